@@ -106,6 +106,16 @@ void CmdLine::parse(int argc, char* argv[])
             options_count += (it - tmp) + 1;
         }
 
+        // UNIX socket path
+        if ((*it).compare("--socket") == 0) {
+            tmp = it;
+            options_.push_back(*it);
+            options_.push_back(
+                ((it + 1) != cmdline_.end()) ? *(++it) : Constants::Config::socket
+            );
+            options_count += (it - tmp) + 1;
+        }
+
         // help mode
         if ((*it).compare("--help") == 0) {
             options_.push_back(*it);
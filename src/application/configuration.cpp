@@ -11,8 +11,10 @@
 
 #include <unistd.h>
 
+#include <algorithm>
 #include <filesystem>
 #include <iostream>
+#include <thread>
 
 
 // ----- member methods
@@ -61,6 +63,12 @@ void Configuration::fromOptions(CmdLine::Options_t& options)
             clt_port = *(++it);
         }
 
+        // UNIX socket (for both the server and the client)
+        if ((*it).compare("--socket") == 0) {
+            srv_socket = *(++it);
+            clt_socket = srv_socket;
+        }
+
         // help mode
         if ((*it).compare("--help") == 0) {
             is_help = true;
@@ -104,6 +112,81 @@ void Configuration::fromFile()
         database = value;
     }
 
+    // storage engine
+    value = table["database"]["engine"].value_or(""sv);
+    if ((value.size() != 0) && (db_engine.size() == 0)) {
+        db_engine = value;
+    }
+
+    // database journal mode
+    value = table["database"]["journal_mode"].value_or(""sv);
+    if ((value.size() != 0) && (db_journal_mode.size() == 0)) {
+        db_journal_mode = value;
+    }
+
+    // database synchronous mode
+    value = table["database"]["synchronous"].value_or(""sv);
+    if ((value.size() != 0) && (db_synchronous.size() == 0)) {
+        db_synchronous = value;
+    }
+
+    // database memory map size (0 disables it)
+    if (table["database"]["mmap_size"].is_integer())
+    {
+        int64_t number = static_cast<int64_t>(*table["database"]["mmap_size"].as_integer());
+        if ((db_mmap_size < 0) && (number >= 0)) {
+            db_mmap_size = number;
+        }
+    }
+
+    // database page cache (negative: size in KiB)
+    if (table["database"]["cache_size"].is_integer())
+    {
+        int64_t number = static_cast<int64_t>(*table["database"]["cache_size"].as_integer());
+        if ((db_cache_size == 0) && (number != 0)) {
+            db_cache_size = number;
+        }
+    }
+
+    // database page size
+    if (table["database"]["page_size"].is_integer())
+    {
+        int64_t number = static_cast<int64_t>(*table["database"]["page_size"].as_integer());
+        if ((db_page_size == 0) && (number > 0)) {
+            db_page_size = static_cast<int>(number);
+        }
+    }
+
+    // database lock timeout
+    if (table["database"]["busy_timeout"].is_integer())
+    {
+        int64_t number = static_cast<int64_t>(*table["database"]["busy_timeout"].as_integer());
+        if ((db_busy_timeout == 0) && (number > 0)) {
+            db_busy_timeout = static_cast<int>(number);
+        }
+    }
+
+    // database temporary storage
+    value = table["database"]["temp_store"].value_or(""sv);
+    if ((value.size() != 0) && (db_temp_store.size() == 0)) {
+        db_temp_store = value;
+    }
+
+    // values cache size (0 disables it)
+    if (table["cache"]["memory"].is_integer())
+    {
+        int64_t number = static_cast<int64_t>(*table["cache"]["memory"].as_integer());
+        if ((cache_memory < 0) && (number >= 0)) {
+            cache_memory = number;
+        }
+    }
+
+    // values cache eviction policy
+    value = table["cache"]["policy"].value_or(""sv);
+    if ((value.size() != 0) && (cache_policy.size() == 0)) {
+        cache_policy = value;
+    }
+
     // server address
     value = table["server"]["address"].value_or(""sv);
     if ((value.size() != 0) && (srv_address.size() == 0)) {
@@ -124,6 +207,36 @@ void Configuration::fromFile()
         }
     }
 
+    // server threads
+    if (table["server"]["threads"].is_integer())
+    {
+        int64_t number = static_cast<int64_t>(*table["server"]["threads"].as_integer());
+        if ((srv_threads == 0) && (number > 0)) {
+            srv_threads = static_cast<int>(number);
+        }
+    }
+
+    // server storage workers
+    if (table["server"]["workers"].is_integer())
+    {
+        int64_t number = static_cast<int64_t>(*table["server"]["workers"].as_integer());
+        if ((srv_workers == 0) && (number > 0)) {
+            srv_workers = static_cast<int>(number);
+        }
+    }
+
+    // server I/O backend
+    value = table["server"]["backend"].value_or(""sv);
+    if ((value.size() != 0) && (srv_backend.size() == 0)) {
+        srv_backend = value;
+    }
+
+    // server UNIX socket
+    value = table["server"]["socket"].value_or(""sv);
+    if ((value.size() != 0) && (srv_socket.size() == 0)) {
+        srv_socket = value;
+    }
+
     // client address
     value = table["client"]["address"].value_or(""sv);
     if ((value.size() != 0) && (clt_address.size() == 0)) {
@@ -143,6 +256,12 @@ void Configuration::fromFile()
             clt_port = value;
         }
     }
+
+    // client UNIX socket
+    value = table["client"]["socket"].value_or(""sv);
+    if ((value.size() != 0) && (clt_socket.size() == 0)) {
+        clt_socket = value;
+    }
 }
 
 void Configuration::finalize()
@@ -158,12 +277,59 @@ void Configuration::finalize()
     if (database.size() == 0)
         database = Constants::Config::database;
 
+    if (db_engine.size() == 0)
+        db_engine = Constants::Config::db_engine;
+
+    if (db_journal_mode.size() == 0)
+        db_journal_mode = Constants::Config::db_journal_mode;
+
+    if (db_synchronous.size() == 0)
+        db_synchronous = Constants::Config::db_synchronous;
+
+    if (db_mmap_size < 0)
+        db_mmap_size = Constants::Config::db_mmap_size;
+
+    if (db_cache_size == 0)
+        db_cache_size = Constants::Config::db_cache_size;
+
+    if (db_page_size == 0)
+        db_page_size = Constants::Config::db_page_size;
+
+    if (db_busy_timeout == 0)
+        db_busy_timeout = Constants::Config::db_busy_timeout;
+
+    if (db_temp_store.size() == 0)
+        db_temp_store = Constants::Config::db_temp_store;
+
+    if (cache_memory < 0)
+        cache_memory = Constants::Config::cache_memory;
+
+    if (cache_policy.size() == 0)
+        cache_policy = Constants::Config::cache_policy;
+
     if (srv_address.size() == 0)
         srv_address = Constants::Config::srv_address;
 
     if (srv_port.size() == 0)
         srv_port = Constants::Config::srv_port;
 
+    if (srv_threads == 0)
+        srv_threads = Constants::Config::srv_threads;
+
+    // one thread per core
+    if (srv_threads <= 0)
+        srv_threads = std::max(1u, std::thread::hardware_concurrency());
+
+    if (srv_backend.size() == 0)
+        srv_backend = Constants::Config::srv_backend;
+
+    if (srv_workers == 0)
+        srv_workers = Constants::Config::srv_workers;
+
+    // one worker per core
+    if (srv_workers <= 0)
+        srv_workers = std::max(1u, std::thread::hardware_concurrency());
+
     if (clt_address.size() == 0)
         clt_address = Constants::Config::clt_address;
 
@@ -180,11 +346,26 @@ void Configuration::dump()
     std::cerr << "----- Configuration -----\n";
     std::cerr << "filename    : " << filename << "\n";
     std::cerr << "database    : " << database << "\n";
+    std::cerr << "db_engine       : " << db_engine << "\n";
+    std::cerr << "db_journal_mode : " << db_journal_mode << "\n";
+    std::cerr << "db_synchronous  : " << db_synchronous << "\n";
+    std::cerr << "db_mmap_size    : " << db_mmap_size << "\n";
+    std::cerr << "db_cache_size   : " << db_cache_size << "\n";
+    std::cerr << "db_page_size    : " << db_page_size << "\n";
+    std::cerr << "db_busy_timeout : " << db_busy_timeout << "\n";
+    std::cerr << "db_temp_store   : " << db_temp_store << "\n";
+    std::cerr << "cache_memory    : " << cache_memory << "\n";
+    std::cerr << "cache_policy    : " << cache_policy << "\n";
     std::cerr << "is_server   : " << std::boolalpha << is_server << "\n";
     std::cerr << "srv_address : " << srv_address << "\n";
     std::cerr << "srv_port    : " << srv_port << "\n";
+    std::cerr << "srv_threads : " << srv_threads << "\n";
+    std::cerr << "srv_backend : " << srv_backend << "\n";
+    std::cerr << "srv_workers : " << srv_workers << "\n";
+    std::cerr << "srv_socket  : " << srv_socket << "\n";
     std::cerr << "clt_address : " << clt_address << "\n";
     std::cerr << "clt_port    : " << clt_port << "\n";
+    std::cerr << "clt_socket  : " << clt_socket << "\n";
     std::cerr << "uid         : " << uid << "\n";
     std::cerr << "gid         : " << gid << "\n";
     std::cerr << "is_help     : " << std::boolalpha << is_help << "\n";
@@ -208,6 +389,26 @@ void Configuration::printHelp()
 
     std::cout << "  --address: server address (default: " << Constants::Config::clt_address << ")\n";
     std::cout << "  --port: server TCP port (default: " << Constants::Config::clt_port << ")\n";
+    std::cout << "  --socket <path>: use a UNIX socket rather than TCP, server and client (default: " << Constants::Config::socket << ")\n";
+    std::cout << "\n";
+    std::cout << "Commands :\n";
+    std::cout << "  set <key> [value] : set a value (read from STDIN if not provided)\n";
+    std::cout << "  get <key> : retrieve a value\n";
+    std::cout << "  delete <key> : delete a key\n";
+    std::cout << "  exists <key> : check if a key exists\n";
+    std::cout << "  print <regexp> : list the keys matching a regular expression (whole key, ECMAScript)\n";
+    std::cout << "  scan <cursor> [count] : list the keys in order, from the cursor 0 then the cursor returned (first line)\n";
+    std::cout << "  mget <key>... : retrieve the values of several keys, one per line\n";
+    std::cout << "  mset <key> <value>... : set several keys at once\n";
+    std::cout << "  mdel <key>... : delete several keys at once\n";
+    std::cout << "  incrby <key> <delta> : add to the integer value of a key (0 if missing), print the new value\n";
+    std::cout << "  decrby <key> <delta> : subtract from the integer value of a key (0 if missing), print the new value\n";
+    std::cout << "  append <key> [value] : append to the value of a key (read from STDIN if not provided), print the new size\n";
+    std::cout << "  cas <key> <expected> <value> : set a value if the current one is the expected one\n";
+    std::cout << "  setnx <key> <value> : set a value if the key doesn't exist\n";
+    std::cout << "  expire <key> <seconds> : delete a key after a number of seconds\n";
+    std::cout << "  expireat <key> <timestamp> : delete a key at a time in seconds since the epoch (0: never)\n";
+    std::cout << "  batch : execute the commands read from STDIN, one per line, on a single connection\n";
 
     std::cout << std::endl;
 }
@@ -10,6 +10,7 @@
 // ----- includes
 #include "cmdline.h"
 
+#include <cstdint>
 #include <string>
 
 
@@ -22,13 +23,28 @@ namespace Application
         // ----- members
         std::string filename{};         //< TOML configuration file path
         std::string database{};         //< SQLite database path
+        std::string db_engine{};        //< storage engine (default: sqlite)
+        std::string db_journal_mode{};  //< SQLite journal mode (default: WAL)
+        std::string db_synchronous{};   //< SQLite synchronous mode (default: NORMAL)
+        std::int64_t db_mmap_size{-1};  //< SQLite memory map size in bytes (-1 until set)
+        std::int64_t db_cache_size{};   //< SQLite page cache, pages or KiB if negative
+        int db_page_size{};             //< SQLite page size of a new database
+        int db_busy_timeout{};          //< SQLite lock wait in ms
+        std::string db_temp_store{};    //< SQLite temporary tables storage (default: MEMORY)
+        std::int64_t cache_memory{-1};  //< values cache size in bytes, 0 disables it (-1 until set)
+        std::string cache_policy{};     //< values cache eviction policy (default: LRU)
 
         bool is_server{false};          //< true if the application is running in server mode (client otherwise)
         std::string srv_address{};      //< the binding interface address (default: 0.0.0.0)
         std::string srv_port{};         //< the binding port (default: 4567)
+        int srv_threads{};              //< number of TCP threads (default: one per core)
+        std::string srv_backend{};      //< the network I/O backend (default: epoll)
+        int srv_workers{};              //< number of storage workers (default: one per core)
+        std::string srv_socket{};       //< UNIX socket path, replaces TCP when set
 
         std::string clt_address{};      //< the TCP address for the client connection (default: localhost)
         std::string clt_port{};         //< the TCP port for the client connection (default: 4567)
+        std::string clt_socket{};       //< UNIX socket path, replaces TCP when set
 
         int uid{};                      //< Unix user ID
         int gid{};                      //< Unix group ID
@@ -9,6 +9,8 @@
 
 // ----- includes
 #include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
 // ----- namespace definition
@@ -23,19 +25,53 @@ namespace Constants::Config
 {
     inline static std::string filename{"configuration.toml"};
     inline static std::string database{"/etc/kvstore.db"};
+    inline static std::string db_engine{"sqlite"};          //< "sqlite", "log" or "memory"
 
     inline static std::string srv_address{"0.0.0.0"};
     inline static std::string srv_port{"4567"};
+    inline static int srv_threads{0};                       //< 0: one thread per core
+    inline static std::string srv_backend{"epoll"};         //< "epoll" or "io_uring"
+    inline static int srv_workers{0};                       //< 0: one storage worker per core
+
+    inline static std::string socket{"/tmp/kvstore.sock"};   //< UNIX socket (--socket without a path)
 
     inline static std::string clt_address{"localhost"};
     inline static std::string clt_port{"4567"};
+
+    // SQLite tuning, [database] section
+    inline static std::string db_journal_mode{"WAL"};       //< readers don't block the writer
+    inline static std::string db_synchronous{"NORMAL"};     //< safe with WAL, no fsync per commit
+    inline static std::int64_t db_mmap_size{1 << 28};       //< bytes of the file mapped in memory
+    inline static std::int64_t db_cache_size{-65536};       //< pages, or KiB when negative
+    inline static int db_page_size{4096};                   //< only applied to a new database
+    inline static int db_busy_timeout{5000};                //< wait for a lock in ms
+    inline static std::string db_temp_store{"MEMORY"};
+
+    // values cache, [cache] section
+    inline static std::int64_t cache_memory{1 << 26};       //< bytes kept in memory (0: disabled)
+    inline static std::string cache_policy{"LRU"};          //< LRU or CLOCK
 }
 
 namespace Constants::Network
 {
-    inline static int server_listen_max{5};
-    inline static int epoll_max_events{10};
+    using namespace std::chrono_literals;
+    inline static int server_listen_max{1024};                //< pending connections backlog
+    inline static int epoll_max_events{256};
     inline static int epoll_timeout{200};                   //< timeout in ms
+    inline constexpr std::chrono::seconds idle_timeout{60s};    //< close connections inactive for too long
+
+    inline static int max_pipeline{64};                     //< max requests in flight per connection
+    inline static std::size_t max_pending_output{1 << 20};  //< no more requests dispatched while more bytes are not sent
+    inline static int stall_retry{1};                       //< ms between two hand-overs of a request refused by the workers
+
+    inline constexpr int max_iovec{64};                     //< max blocks sent with a single sendmsg()
+    inline static std::size_t min_gather_size{1024};        //< smaller blocks are copied rather than referenced
+    inline static std::size_t min_direct_read{1 << 16};     //< larger blocks are received in place (epoll)
+
+    inline static unsigned uring_entries{256};              //< io_uring submission queue size
+    inline static unsigned uring_buffers{256};              //< number of provided receive buffers (power of 2)
+    inline static unsigned uring_buffer_size{16384};        //< size of a provided receive buffer
+    inline static std::uint16_t uring_buffer_group{0};      //< provided buffers group ID
 }
 
 namespace Constants::Network::Protocol
@@ -44,13 +80,69 @@ namespace Constants::Network::Protocol
     inline static std::uint8_t eot{0xFB};                       //< end of transmission
     inline static std::uint16_t max_item_size{(1 << 16) - 1};   //< max item size
 
-    inline static int max_read_buffer{1024};                    //< max read buffer for client / server
+    // v2 frames: fixed size header with the lengths of the key and the value
+    inline static std::uint8_t magic{0xFC};                     //< first byte of a v2 frame (instead of sot)
+    inline static std::uint8_t version{2};
+    inline static std::uint64_t max_payload_size{1 << 28};      //< larger frames are rejected
+
+    inline static int max_read_buffer{1 << 16};                 //< size of a single read for client / server
+    inline static std::size_t max_buffer_keep{1 << 20};         //< larger buffers are released once empty
+}
+
+namespace Constants::VM
+{
+    inline static std::size_t arena_block_size{8192};           //< larger allocations get their own block
+    inline static std::size_t arena_cache{64};                  //< arenas kept by a thread for reuse
+}
+
+namespace Constants::Database
+{
+    inline static int schema_version{2};                        //< stored in PRAGMA user_version
+}
+
+namespace Constants::Cache
+{
+    inline static std::size_t shards{16};                       //< locked separately (power of 2)
+    inline static std::size_t max_entry_share{8};               //< an entry takes at most 1/8 of a shard
+}
+
+namespace Constants::Storage
+{
+    using namespace std::chrono_literals;
+    inline static std::uint64_t segment_size{1 << 26};          //< a new segment is started past this size
+    inline static double compaction_ratio{0.5};                 //< dead bytes of the old segments to compact them
+    inline constexpr std::chrono::seconds compaction_interval{30s};
+    inline static std::size_t compaction_buffer{1 << 20};       //< records copied with a single write
+    inline static bool log_sync{false};                         //< sync each batch (otherwise left to the kernel)
+    inline static std::uint64_t hint_magic{0x544E4948474F4C4BULL};
+    inline constexpr std::chrono::seconds purge_interval{1s};  //< the expired keys are deleted in the background
+    inline static int purge_batch{256};                         //< keys deleted per transaction
+}
+
+namespace Constants::Worker
+{
+    using namespace std::chrono_literals;
+    inline static std::size_t queue_size{4096};                 //< max tasks waiting for a worker
+    inline static int spin_count{64};                           //< polls of the queue before sleeping
+    inline constexpr std::chrono::milliseconds sleep_timeout{200ms};
+    inline static std::size_t max_batch{256};                   //< max tasks executed together (group commit)
+    inline constexpr std::chrono::microseconds batch_window{100us};    //< wait for more tasks while they keep coming
+}
+
+namespace Constants::KVClient
+{
+    inline static int pipeline_window{256};                     //< max requests in flight in batch mode
+    inline static std::uint32_t stdin_block_size{1 << 20};      //< a value read from STDIN is sent in blocks of this size
 }
 
 namespace Constants::KVServer
 {
     using namespace std::chrono_literals;
     inline constexpr std::chrono::milliseconds kvserver_mainloop_timeout{200ms};
+    inline static std::size_t scan_chunk_size{1 << 14};         //< keys listed sent in parts of this size
+    inline static std::size_t pattern_cache_size{64};           //< compiled patterns kept for the next scans
+    inline static std::int64_t scan_page_size{1000};            //< keys per page of a SCAN (default)
+    inline static std::int64_t scan_page_max{10000};            //< keys per page of a SCAN (max)
 }
 
 #endif // CONSTANTS_H
\ No newline at end of file
@@ -0,0 +1,310 @@
+/*
+ * @file    kvcache.cpp
+ * @brief   Source for the KVCache class
+ */
+
+// ----- includes
+#include "constants.h"
+#include "kvcache.h"
+
+#include <strings.h>
+
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <mutex>
+
+
+// ----- class
+
+// constructor
+KVCache::KVCache(CacheSettings settings) :
+    policy_{Policy_t::LRU}, shard_budget_{0}, shards_{}, epoch_{0}, writing_{0}
+{
+    if (strcasecmp(settings.policy.c_str(), "LRU") == 0) {
+        policy_ = Policy_t::LRU;
+    } else if (strcasecmp(settings.policy.c_str(), "CLOCK") == 0) {
+        policy_ = Policy_t::CLOCK;
+    } else {
+        std::cerr << "Error: invalid cache policy [" << settings.policy << "]\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    if (settings.memory <= 0)
+        return;
+
+    shard_budget_ = static_cast<std::size_t>(settings.memory) / Constants::Cache::shards;
+    for (std::size_t i = 0; i < Constants::Cache::shards; ++i) {
+        shards_.push_back(new Shard{});
+    }
+}
+
+// destructor
+KVCache::~KVCache()
+{
+    clear();
+
+    for (auto* shard : shards_) {
+        delete shard;
+    }
+    shards_.clear();
+}
+
+// false if no memory has been given to the cache
+bool KVCache::enabled() const
+{
+    return !shards_.empty();
+}
+
+// memory accounted for an entry: the data, the entry and its node in the map
+std::size_t KVCache::Entry::cost() const
+{
+    return sizeof(Entry) + sizeof(Entries::value_type) + 2 * sizeof(void*) + ksize + vsize;
+}
+
+// the shard is selected with the high bits, the map uses the low bits
+KVCache::Shard& KVCache::shard(const Storage::Key& key)
+{
+    std::size_t hash = Storage::KeyHash{}(key);
+    return *shards_[(hash >> 32) & (Constants::Cache::shards - 1)];
+}
+
+// return the current write epoch
+std::uint64_t KVCache::ticket() const
+{
+    return epoch_.load();
+}
+
+// return a copy of the value cached for the key
+DBResult* KVCache::fetch(const std::uint8_t* key, int ksize, int uid)
+{
+    if (!enabled())
+        return nullptr;
+
+    Storage::Key lookup = Storage::makeKey(key, ksize, uid);
+    Shard& shard = this->shard(lookup);
+    Entry* entry{nullptr};
+
+    // with CLOCK the readers only mark the entry: they don't block each other
+    std::shared_lock<std::shared_mutex> shared(shard.mutex, std::defer_lock);
+    std::unique_lock<std::shared_mutex> exclusive(shard.mutex, std::defer_lock);
+    if (policy_ == Policy_t::CLOCK) {
+        shared.lock();
+    } else {
+        exclusive.lock();
+    }
+
+    auto it = shard.entries.find(lookup);
+    if (it == shard.entries.end())
+        return nullptr;
+
+    // an expired entry is left for the eviction (or the purge of the key)
+    entry = it->second;
+    if ((entry->expiry != 0) && (entry->expiry <= std::time(nullptr)))
+        return nullptr;
+
+    if (policy_ == Policy_t::CLOCK) {
+        entry->referenced = true;
+    } else {
+        unlink(shard, entry);
+        link(shard, entry);
+    }
+
+    // the buffer is handed over to the response
+    DBResult* result = new DBResult{
+        size: entry->vsize,
+        pData: new std::uint8_t[entry->vsize],
+        expiry: entry->expiry
+    };
+    memcpy(result->pData, entry->pData + entry->ksize, entry->vsize);
+
+    return result;
+}
+
+// check if the key is in the cache
+bool KVCache::contains(const std::uint8_t* key, int ksize, int uid)
+{
+    if (!enabled())
+        return false;
+
+    Storage::Key lookup = Storage::makeKey(key, ksize, uid);
+    Shard& shard = this->shard(lookup);
+
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    auto it = shard.entries.find(lookup);
+    if (it == shard.entries.end())
+        return false;
+
+    std::int64_t expiry = it->second->expiry;
+    return (expiry == 0) || (expiry > std::time(nullptr));
+}
+
+// add a value read from the database
+void KVCache::fill(const std::uint8_t* key, int ksize, const std::uint8_t* value, int vsize, int uid,
+                   std::int64_t expiry, std::uint64_t ticket)
+{
+    if (!enabled())
+        return;
+
+    Storage::Key lookup = Storage::makeKey(key, ksize, uid);
+    Shard& shard = this->shard(lookup);
+
+    // the writer updates the shard under the same lock: once checked,
+    // a newer value can only replace this one
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    if ((writing_ > 0) || (epoch_ != ticket))
+        return;
+
+    insert(shard, lookup, value, vsize, expiry);
+}
+
+// a write transaction starts, the readers stop filling the cache
+void KVCache::begin()
+{
+    writing_++;
+    epoch_++;
+}
+
+// the write transaction is over (committed or rolled back)
+void KVCache::end()
+{
+    epoch_++;
+    writing_--;
+}
+
+// set the value of a key written in the database
+void KVCache::store(const std::uint8_t* key, int ksize, const std::uint8_t* value, int vsize, int uid)
+{
+    if (!enabled())
+        return;
+
+    Storage::Key lookup = Storage::makeKey(key, ksize, uid);
+    Shard& shard = this->shard(lookup);
+
+    // a new value has no expiry
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    insert(shard, lookup, value, vsize, 0);
+}
+
+// remove a key from the cache
+void KVCache::erase(const std::uint8_t* key, int ksize, int uid)
+{
+    if (!enabled())
+        return;
+
+    Storage::Key lookup = Storage::makeKey(key, ksize, uid);
+    Shard& shard = this->shard(lookup);
+
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    auto it = shard.entries.find(lookup);
+    if (it != shard.entries.end()) {
+        remove(shard, it->second);
+    }
+}
+
+// remove all the entries
+void KVCache::clear()
+{
+    for (auto* shard : shards_) {
+        std::unique_lock<std::shared_mutex> lock(shard->mutex);
+        while (shard->head != nullptr) {
+            remove(*shard, shard->head);
+        }
+    }
+}
+
+// add or replace an entry, the shard must be locked
+void KVCache::insert(Shard& shard, const Storage::Key& key, const std::uint8_t* value, int vsize, std::int64_t expiry)
+{
+    // the previous value is replaced by a new entry
+    auto it = shard.entries.find(key);
+    if (it != shard.entries.end()) {
+        remove(shard, it->second);
+    }
+
+    Entry* entry = new Entry{};
+    entry->uid = key.uid;
+    entry->ksize = static_cast<int>(key.key.size());
+    entry->vsize = vsize;
+    entry->expiry = expiry;
+    entry->referenced = false;
+
+    // a large value would flush the whole shard
+    std::size_t cost = entry->cost();
+    if (cost > shard_budget_ / Constants::Cache::max_entry_share) {
+        delete entry;
+        return;
+    }
+
+    evict(shard, cost);
+
+    entry->pData = new std::uint8_t[entry->ksize + vsize];
+    memcpy(entry->pData, key.key.data(), entry->ksize);
+    memcpy(entry->pData + entry->ksize, value, vsize);
+
+    Storage::Key owned = Storage::makeKey(entry->pData, entry->ksize, entry->uid);
+    shard.entries[owned] = entry;
+    shard.used += cost;
+    link(shard, entry);
+}
+
+// delete an entry, the shard must be locked
+void KVCache::remove(Shard& shard, Entry* entry)
+{
+    Storage::Key owned = Storage::makeKey(entry->pData, entry->ksize, entry->uid);
+    shard.entries.erase(owned);
+    shard.used -= entry->cost();
+    unlink(shard, entry);
+    delete entry;
+}
+
+// remove the entries at the end of the list until the new entry fits
+// with CLOCK, an entry hit since the last pass gets a second chance
+void KVCache::evict(Shard& shard, std::size_t needed)
+{
+    while ((shard.tail != nullptr) && (shard.used + needed > shard_budget_))
+    {
+        Entry* entry = shard.tail;
+
+        if ((policy_ == Policy_t::CLOCK) && entry->referenced) {
+            entry->referenced = false;
+            unlink(shard, entry);
+            link(shard, entry);
+            continue;
+        }
+
+        remove(shard, entry);
+    }
+}
+
+// add an entry in front of the list
+void KVCache::link(Shard& shard, Entry* entry)
+{
+    entry->prev = nullptr;
+    entry->next = shard.head;
+    if (shard.head) {
+        shard.head->prev = entry;
+    } else {
+        shard.tail = entry;
+    }
+    shard.head = entry;
+}
+
+// take an entry out of the list
+void KVCache::unlink(Shard& shard, Entry* entry)
+{
+    if (entry->prev) {
+        entry->prev->next = entry->next;
+    } else {
+        shard.head = entry->next;
+    }
+
+    if (entry->next) {
+        entry->next->prev = entry->prev;
+    } else {
+        shard.tail = entry->prev;
+    }
+
+    entry->prev = nullptr;
+    entry->next = nullptr;
+}
@@ -0,0 +1,120 @@
+/*
+ * @file    kvcache.h
+ * @brief   Header for the KVCache class
+ */
+
+// ----- guards
+#ifndef KVCACHE_H
+#define KVCACHE_H
+
+// ----- includes
+#include "storage/engine.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+// ----- structures
+
+// bounded cache of the values in front of the database, [cache] section
+struct CacheSettings
+{
+    std::int64_t memory;            //< bytes of keys and values kept in memory (0: disabled)
+    std::string policy;             //< eviction policy: LRU or CLOCK
+};
+
+// ----- class
+
+// in-memory cache of the (user, key) -> value entries, split in shards locked separately
+// the database stays the reference: the writes go through the cache to the database
+class KVCache
+{
+public:     //< public methods
+    KVCache(CacheSettings settings);
+    ~KVCache();
+
+    bool enabled() const;
+
+    // the readers fill the cache after a miss, a fill is dropped if a write
+    // happened since the ticket was taken (the value read may be outdated)
+    std::uint64_t ticket() const;
+    DBResult* fetch(const std::uint8_t* key, int ksize, int uid);     //< nullptr on a miss
+    bool contains(const std::uint8_t* key, int ksize, int uid);
+    void fill(const std::uint8_t* key, int ksize, const std::uint8_t* value, int vsize, int uid,
+              std::int64_t expiry, std::uint64_t ticket);
+
+    // the writer updates the cache with the database, between begin() and end()
+    // a key is erased when its expiry changes, the next read fills it again
+    void begin();
+    void end();
+    void store(const std::uint8_t* key, int ksize, const std::uint8_t* value, int vsize, int uid);
+    void erase(const std::uint8_t* key, int ksize, int uid);
+    void clear();                   //< drop everything (the database has been rolled back)
+
+    // no copy
+    KVCache(const KVCache&) = delete;
+    KVCache& operator=(const KVCache&) = delete;
+
+    // no move
+    KVCache(KVCache&&) = delete;
+    KVCache& operator=(KVCache&&) = delete;
+
+private:    //< private types
+    enum class Policy_t {
+        LRU,                        //< a hit moves the entry in front (exclusive lock)
+        CLOCK,                      //< a hit only marks the entry (shared lock), second chance on eviction
+    };
+
+    // the key and the value are stored in a single block
+    struct Entry
+    {
+        Entry* prev;                //< more recently used (or inserted)
+        Entry* next;                //< less recently used (or inserted)
+        int uid;
+        int ksize;
+        int vsize;
+        std::int64_t expiry;        //< of the value read (0: none), an expired entry is a miss
+        std::atomic<bool> referenced;   //< hit since the last pass of the clock
+        std::uint8_t* pData;
+
+        std::size_t cost() const;   //< memory accounted for the entry
+        ~Entry() {
+            delete [] pData;
+        }
+    };
+
+    // the key of the map points to the data of the entry
+    using Entries = std::unordered_map<Storage::Key, Entry*, Storage::KeyHash>;
+
+    struct Shard
+    {
+        std::shared_mutex mutex;
+        Entries entries;
+        Entry* head;                //< most recent entry
+        Entry* tail;                //< next entry to evict
+        std::size_t used;           //< memory used by the entries
+    };
+
+private:    //< private methods
+    Shard& shard(const Storage::Key& key);
+    void insert(Shard& shard, const Storage::Key& key, const std::uint8_t* value, int vsize, std::int64_t expiry);
+    void remove(Shard& shard, Entry* entry);
+    void evict(Shard& shard, std::size_t needed);     //< make room for a new entry
+    void link(Shard& shard, Entry* entry);           //< add in front of the list
+    void unlink(Shard& shard, Entry* entry);
+
+
+private:    //< private members
+    Policy_t policy_;
+    std::size_t shard_budget_;      //< memory allowed per shard
+    std::vector<Shard*> shards_;    //< empty if the cache is disabled
+    std::atomic<std::uint64_t> epoch_;      //< incremented by each write transaction
+    std::atomic<int> writing_;      //< write transactions in progress
+};
+
+#endif // KVCACHE_H
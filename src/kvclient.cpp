@@ -8,22 +8,29 @@
 #include "kvclient.h"
 
 #include <fcntl.h>
+#include <poll.h>
 #include <stdio.h>
 #include <string.h>
 #include <unistd.h>
 
 
 #include <iostream>
+#include <string>
+#include <vector>
 
 
 // ----- class
 
 // constructor
-KVClient::KVClient(std::string address, std::string port) :
+KVClient::KVClient(std::string address, std::string port, std::string socket) :
     pClient_{nullptr}
 {
-    // create a new TCPClient
-    pClient_ = new Network::TCPClient(address, port);
+    // create a new TCPClient (on a UNIX socket if a path is provided)
+    if (socket.size() != 0) {
+        pClient_ = new Network::TCPClient(socket);
+    } else {
+        pClient_ = new Network::TCPClient(address, port);
+    }
     if (!pClient_) {
         std::cerr << "Error: unable to create a TCPClient instance\n";
         std::exit(EXIT_FAILURE);
@@ -34,18 +41,20 @@ KVClient::KVClient(std::string address, std::string port) :
 KVClient::~KVClient()
 {
     // delete all the remaining items in the queue
-    while (items_.size() > 0) {
-        auto* elt = items_.front();
-        items_.pop();
-
-        delete elt;
-    }
+    freeItems();
 
     // delete the client
     delete pClient_;
     pClient_ = nullptr;
 }
 
+// forget all the items in the queue
+// their memory is released with the arena once the frames are sent
+void KVClient::freeItems()
+{
+    items_ = VM::queue_t{};
+}
+
 // set user UID/GID
 void KVClient::setUser(int uid, int gid)
 {
@@ -54,34 +63,35 @@ void KVClient::setUser(int uid, int gid)
 }
 
 // parse the command line and create the linked list
-void KVClient::parse(Application::CmdLine& cmdline)
+bool KVClient::parse(Application::CmdLine& cmdline)
+{
+    return parse(cmdline.args());
+}
+
+// parse a command and create the linked list
+// return false if the command is not valid
+bool KVClient::parse(const Application::CmdLine::Args_t& args)
 {
-    Application::CmdLine::Args_t::const_iterator it = cmdline.args().cbegin();
-    Application::CmdLine::Args_t::const_iterator end = cmdline.args().cend();
+    Application::CmdLine::Args_t::const_iterator it = args.cbegin();
+    Application::CmdLine::Args_t::const_iterator end = args.cend();
+
+    int args_size = args.size();
 
-    int args_size = cmdline.args().size();
+    // all the commands require at least a key
+    if (args_size < 2) {
+        std::cerr << "Error: missing key name!\n";
+        return false;
+    }
 
     while (it != end)
     {
         // set a new value
         if ((*it).compare("set") == 0) {
-            VM::QueueItem* item = new VM::QueueItem {
-                opcode: VM::Opcodes_t::OP_SET,
-                szdata: 0,
-                pdata: nullptr
-            };
-            items_.push(item);
+            items_.push(VM::createItem(&arena_, VM::Opcodes_t::OP_SET, 0));
             ++it;
 
             // add the userId
-            std::uint8_t* user_id = new std::uint8_t[sizeof(uid_)];
-            memcpy(user_id, &uid_, sizeof(uid_));
-            item = new VM::QueueItem {
-                opcode: VM::Opcodes_t::U_USER,
-                szdata: sizeof(uid_),
-                pdata: user_id
-            };
-            items_.push(item);
+            items_.push(VM::createItem(&arena_, VM::Opcodes_t::U_USER, &uid_, sizeof(uid_)));
 
             // read the Key Name
             getKeyName(*(it++));
@@ -98,23 +108,11 @@ void KVClient::parse(Application::CmdLine& cmdline)
 
         // get a value
         if ((*it).compare("get") == 0) {
-            VM::QueueItem* item = new VM::QueueItem {
-                opcode: VM::Opcodes_t::OP_GET,
-                szdata: 0,
-                pdata: nullptr
-            };
-            items_.push(item);
+            items_.push(VM::createItem(&arena_, VM::Opcodes_t::OP_GET, 0));
             ++it;
 
             // add the userId
-            std::uint8_t* user_id = new std::uint8_t[sizeof(uid_)];
-            memcpy(user_id, &uid_, sizeof(uid_));
-            item = new VM::QueueItem {
-                opcode: VM::Opcodes_t::U_USER,
-                szdata: sizeof(uid_),
-                pdata: user_id
-            };
-            items_.push(item);
+            items_.push(VM::createItem(&arena_, VM::Opcodes_t::U_USER, &uid_, sizeof(uid_)));
 
             // read the key name
             getKeyName(*(it++));
@@ -124,23 +122,11 @@ void KVClient::parse(Application::CmdLine& cmdline)
 
         // delete a key
         if ((*it).compare("delete") == 0) {
-            VM::QueueItem* item = new VM::QueueItem {
-                opcode: VM::Opcodes_t::OP_DEL,
-                szdata: 0,
-                pdata: nullptr
-            };
-            items_.push(item);
+            items_.push(VM::createItem(&arena_, VM::Opcodes_t::OP_DEL, 0));
             ++it;
 
             // add the userId
-            std::uint8_t* user_id = new std::uint8_t[sizeof(uid_)];
-            memcpy(user_id, &uid_, sizeof(uid_));
-            item = new VM::QueueItem {
-                opcode: VM::Opcodes_t::U_USER,
-                szdata: sizeof(uid_),
-                pdata: user_id
-            };
-            items_.push(item);
+            items_.push(VM::createItem(&arena_, VM::Opcodes_t::U_USER, &uid_, sizeof(uid_)));
 
             // read the key name
             getKeyName(*(it++));
@@ -150,23 +136,11 @@ void KVClient::parse(Application::CmdLine& cmdline)
 
         // check if a key exists
         if ((*it).compare("exists") == 0) {
-            VM::QueueItem* item = new VM::QueueItem {
-                opcode: VM::Opcodes_t::OP_EXIST,
-                szdata: 0,
-                pdata: nullptr
-            };
-            items_.push(item);
+            items_.push(VM::createItem(&arena_, VM::Opcodes_t::OP_EXIST, 0));
             ++it;
 
             // add the userId
-            std::uint8_t* user_id = new std::uint8_t[sizeof(uid_)];
-            memcpy(user_id, &uid_, sizeof(uid_));
-            item = new VM::QueueItem {
-                opcode: VM::Opcodes_t::U_USER,
-                szdata: sizeof(uid_),
-                pdata: user_id
-            };
-            items_.push(item);
+            items_.push(VM::createItem(&arena_, VM::Opcodes_t::U_USER, &uid_, sizeof(uid_)));
 
             // read the key name
             getKeyName(*(it++));
@@ -174,42 +148,176 @@ void KVClient::parse(Application::CmdLine& cmdline)
             break;
         }
 
-    }
-}
+        // list the keys matching a regular expression
+        if ((*it).compare("print") == 0) {
+            items_.push(VM::createItem(&arena_, VM::Opcodes_t::OP_PRT, 0));
+            ++it;
 
-// create an item from an args (Name or Value)
-void KVClient::itemFromArg(std::string_view arg, VM::Opcodes_t opcode)
-{
-    const char* c = arg.data();
-    int item_size = arg.size();
-    int count = 0;
+            // add the userId
+            items_.push(VM::createItem(&arena_, VM::Opcodes_t::U_USER, &uid_, sizeof(uid_)));
 
-    while (count < item_size)
-    {
-        int remaining = item_size - count;
+            // the pattern is sent as the key name
+            getKeyName(*(it++));
 
-        // ensure we create only block of 64KiB
-        int block_size = 0;
-        if (remaining > Constants::Network::Protocol::max_item_size) {
-            block_size = Constants::Network::Protocol::max_item_size;
-        } else {
-            block_size = remaining;
+            break;
         }
 
-        // create a new block
-        VM::QueueItem* item = new VM::QueueItem {
-            opcode: opcode,
-            szdata: static_cast<std::uint16_t>(block_size),
-            pdata: new std::uint8_t[block_size]
-        };
+        // list the keys in pages, from the cursor "0" then the cursor returned
+        if ((*it).compare("scan") == 0) {
+            items_.push(VM::createItem(&arena_, VM::Opcodes_t::OP_SCAN, 0));
+            ++it;
+
+            // add the userId
+            items_.push(VM::createItem(&arena_, VM::Opcodes_t::U_USER, &uid_, sizeof(uid_)));
+
+            // the cursor is sent as the key name, the count as the value
+            getKeyName(*(it++));
+            if (it != end) {
+                itemFromArg(*(it++), VM::Opcodes_t::V_VALUE);
+            }
+
+            break;
+        }
+
+        // several keys (and values) in a single command, each one is an entry of the value
+        if (((*it).compare("mget") == 0) || ((*it).compare("mset") == 0) || ((*it).compare("mdel") == 0)) {
+            VM::Opcodes_t opcode = VM::Opcodes_t::OP_MGET;
+            if ((*it).compare("mset") == 0) {
+                opcode = VM::Opcodes_t::OP_MSET;
+            } else if ((*it).compare("mdel") == 0) {
+                opcode = VM::Opcodes_t::OP_MDEL;
+            }
+
+            if ((opcode == VM::Opcodes_t::OP_MSET) && ((args_size % 2) == 0)) {
+                std::cerr << "Error: missing value!\n";
+                return false;
+            }
+
+            items_.push(VM::createItem(&arena_, opcode, 0));
+            ++it;
+
+            // add the userId
+            items_.push(VM::createItem(&arena_, VM::Opcodes_t::U_USER, &uid_, sizeof(uid_)));
+
+            // the values are never read from STDIN
+            for (; it != end; ++it) {
+                items_.push(VM::createEntry(&arena_, VM::Opcodes_t::V_VALUE, (*it).data(), (*it).size()));
+            }
+
+            break;
+        }
+
+        // update a counter, the delta is never read from STDIN
+        if (((*it).compare("incrby") == 0) || ((*it).compare("decrby") == 0)) {
+            VM::Opcodes_t opcode = ((*it).compare("incrby") == 0) ? VM::Opcodes_t::OP_INCR : VM::Opcodes_t::OP_DECR;
+            if (args_size < 3) {
+                std::cerr << "Error: missing increment!\n";
+                return false;
+            }
+
+            items_.push(VM::createItem(&arena_, opcode, 0));
+            ++it;
+
+            // add the userId
+            items_.push(VM::createItem(&arena_, VM::Opcodes_t::U_USER, &uid_, sizeof(uid_)));
+
+            // read the key name then the delta
+            getKeyName(*(it++));
+            itemFromArg(*(it++), VM::Opcodes_t::V_VALUE);
+
+            break;
+        }
+
+        // append data to the value of a key
+        if ((*it).compare("append") == 0) {
+            items_.push(VM::createItem(&arena_, VM::Opcodes_t::OP_APPEND, 0));
+            ++it;
+
+            // add the userId
+            items_.push(VM::createItem(&arena_, VM::Opcodes_t::U_USER, &uid_, sizeof(uid_)));
+
+            // read the key name
+            getKeyName(*(it++));
+
+            // read the value
+            if (args_size == 2) {
+                getValue("");
+            } else {
+                getValue(*(it++));
+            }
+
+            break;
+        }
+
+        // set a value if the current one is the expected one (cas) or if the key doesn't exist (setnx)
+        if (((*it).compare("cas") == 0) || ((*it).compare("setnx") == 0)) {
+            bool absent = ((*it).compare("setnx") == 0);
+            if (args_size < (absent ? 3 : 4)) {
+                std::cerr << "Error: missing value!\n";
+                return false;
+            }
+
+            items_.push(VM::createItem(&arena_, VM::Opcodes_t::OP_CAS, 0));
+            ++it;
+
+            // add the userId
+            items_.push(VM::createItem(&arena_, VM::Opcodes_t::U_USER, &uid_, sizeof(uid_)));
+
+            // read the key name
+            getKeyName(*(it++));
+
+            // the expected value (if any) and the new one are entries of the value
+            if (!absent) {
+                items_.push(VM::createEntry(&arena_, VM::Opcodes_t::V_VALUE, (*it).data(), (*it).size()));
+                ++it;
+            }
+            items_.push(VM::createEntry(&arena_, VM::Opcodes_t::V_VALUE, (*it).data(), (*it).size()));
+            ++it;
+
+            break;
+        }
+
+        // set the expiry of a key, in seconds from now or since the epoch
+        if (((*it).compare("expire") == 0) || ((*it).compare("expireat") == 0)) {
+            VM::Opcodes_t opcode = ((*it).compare("expire") == 0) ? VM::Opcodes_t::OP_EXPDR : VM::Opcodes_t::OP_EXPDT;
+            if (args_size < 3) {
+                std::cerr << "Error: missing expiry!\n";
+                return false;
+            }
+
+            items_.push(VM::createItem(&arena_, opcode, 0));
+            ++it;
+
+            // add the userId
+            items_.push(VM::createItem(&arena_, VM::Opcodes_t::U_USER, &uid_, sizeof(uid_)));
+
+            // read the key name
+            getKeyName(*(it++));
+
+            // the expiry is never read from STDIN
+            itemFromArg(*(it++), VM::Opcodes_t::V_VALUE);
 
-        // copy the string to the block
-        memcpy(item->pdata, c + count, block_size);
-        count += block_size;
+            break;
+        }
 
-        // add the block to the queue
-        items_.push(item);
+        // unknown command
+        std::cerr << "Error: unknown command [" << *it << "]\n";
+        freeItems();
+        return false;
     }
+
+    return true;
+}
+
+// create an item from an args (Name or Value)
+// a v2 frame carries the whole data in a single block
+void KVClient::itemFromArg(std::string_view arg, VM::Opcodes_t opcode)
+{
+    if (arg.size() == 0)
+        return;
+
+    // create a new block with a copy of the string
+    items_.push(VM::createItem(&arena_, opcode, arg.data(), arg.size()));
 }
 
 
@@ -228,27 +336,32 @@ void KVClient::getValue(std::string_view arg)
     }
 
     // data are passed from STDIN either with "<" or a pipe "|"
-    if (!isatty(fileno(stdin))) {
-        std::uint8_t buffer[Constants::Network::Protocol::max_item_size];
-        while (true)
+    // (not in batch mode where STDIN contains the commands)
+    // the data are read directly in large blocks of the arena, sent without any copy
+    if (!batch_ && !isatty(fileno(stdin))) {
+        bool eof{false};
+        while (!eof)
         {
-            int n = read(fileno(stdin), buffer, Constants::Network::Protocol::max_item_size);
-
-            // nothing to read anymore
-            if (n <= 0)
-                break;
-
-            // create a new block
-            VM::QueueItem* item = new VM::QueueItem {
-                opcode: VM::Opcodes_t::V_VALUE,
-                szdata: static_cast<std::uint16_t>(n),
-                pdata: new std::uint8_t[n]
-            };
-
-            // copy the data to the block
-            memcpy(item->pdata, buffer, n);
+            std::uint32_t block_size = Constants::KVClient::stdin_block_size;
+            VM::QueueItem* item = VM::createItem(&arena_, VM::Opcodes_t::V_VALUE, block_size);
+
+            // fill the block
+            std::uint32_t count{0};
+            while (count < block_size) {
+                int n = read(fileno(stdin), item->pdata + count, block_size - count);
+
+                // nothing to read anymore
+                if (n <= 0) {
+                    eof = true;
+                    break;
+                }
+                count += n;
+            }
 
-            items_.push(item);
+            if (count > 0) {
+                item->szdata = count;
+                items_.push(item);
+            }
         }
     }
 }
@@ -256,97 +369,149 @@ void KVClient::getValue(std::string_view arg)
 // send the command to the server
 void KVClient::send()
 {
-    // connect to the server
-    pClient_->connect();
+    queue();
+    flush();
+}
+
+// add the command to the output list
+// the frames are gathered and sent with a single write
+// the command is sent in a v2 frame: a header with the sizes, the key then the value
+void KVClient::queue()
+{
+    Network::Output& output = output_;
 
-    // send the start of transmission
-    pClient_->send(&Constants::Network::Protocol::sot, 1);
+    VM::FrameHeader header{};
+    header.magic = Constants::Network::Protocol::magic;
+    header.version = Constants::Network::Protocol::version;
+
+    std::vector<VM::QueueItem*> keys;
+    std::vector<VM::QueueItem*> values;
 
     while (!items_.empty())
     {
-        std::uint8_t value{};
-
         // retrieve the item
         auto* item = items_.front();
+        items_.pop();
 
-        // send the opcode
-        value = static_cast<std::uint8_t>(item->opcode);
-        pClient_->send(&value, sizeof(value));
+        switch(item->opcode)
+        {
+            case VM::Opcodes_t::U_USER:
+                memcpy(&header.uid, item->pdata, sizeof(header.uid));
+                break;
 
-        // retrieve the value of the data
-        if (item->szdata == 0) {
-            std::uint16_t zero = 0;
-            pClient_->send(reinterpret_cast<std::uint8_t*>(&zero), sizeof(zero));
-        } else {
-            pClient_->send(reinterpret_cast<std::uint8_t*>(&item->szdata), sizeof(item->szdata));
-            pClient_->send(item->pdata, item->szdata);
+            case VM::Opcodes_t::K_NAME:
+                header.key_length += item->szdata;
+                keys.push_back(item);
+                break;
+
+            case VM::Opcodes_t::V_VALUE:
+                header.value_length += item->szdata;
+                values.push_back(item);
+                break;
+
+            default:
+                header.opcode = static_cast<std::uint8_t>(item->opcode);
+                break;
         }
+    }
+    header.total_length = header.key_length + header.value_length;
+    pending_.push_back(static_cast<VM::Opcodes_t>(header.opcode));
 
-        // delete the item
-        items_.pop();
-        delete item;
+    // send the header
+    output.append(&header, sizeof(header));
+
+    // send the key then the value (the data stays in the arena until sent)
+    for (auto* item : keys) {
+        output.reference(item->pdata, item->szdata);
+    }
+    for (auto* item : values) {
+        output.reference(item->pdata, item->szdata);
     }
+}
+
+// send all the frames queued
+void KVClient::flush()
+{
+    // connect to the server (or reuse the current connection)
+    pClient_->connect();
+
+    pClient_->send(output_);
 
-    // send the end of transmission
-    pClient_->send(&Constants::Network::Protocol::eot, 1);
+    // the frames have been sent
+    arena_.reset();
 }
 
 // receive data from the server
 int KVClient::recv()
 {
-    VM::Opcodes_t op{VM::Opcodes_t::R_ERROR};
-
-    // recreate the items
-    std::uint8_t buffer[Constants::Network::Protocol::max_read_buffer] = {0};
+    Network::Buffer& input = pClient_->input();
 
-    // read the Start-of-Transmission character
-    int n = pClient_->recv(buffer, sizeof(std::uint8_t));
-
-    if (buffer[0] != Constants::Network::Protocol::sot) {
-        std::cerr << "Error: unable to find the SOT marker! [" << std::hex << buffer[0] << "]\n";
-        // purge the socket
-        while(n > 0) {
-            n = pClient_->recv(buffer, Constants::Network::Protocol::max_read_buffer);
-        }
-        return -1;
+    // the results of a command on several keys are decoded once received
+    VM::Opcodes_t command{VM::Opcodes_t::OP_GET};
+    if (!pending_.empty()) {
+        command = pending_.front();
+        pending_.pop_front();
     }
+    bool multi = (command == VM::Opcodes_t::OP_MGET) || (command == VM::Opcodes_t::OP_MSET) ||
+                 (command == VM::Opcodes_t::OP_MDEL);
+    std::string results;
 
-    // wait for the End-of-Transmission character
-    while (true)
+    // wait for the whole frame (all the frames of a streamed response)
+    while (!parser_.isComplete() || parser_.hasMore())
     {
-        // read the next character
-        n = pClient_->recv(buffer, sizeof(std::uint8_t));
-        if ((buffer[0] == Constants::Network::Protocol::eot) || (n <= 0)) {
-            break;
+        // the response continues in the next frame
+        if (parser_.isComplete()) {
+            parser_.reset();
+            continue;
         }
 
-        // this is an opcode
-        op = static_cast<VM::Opcodes_t>(buffer[0]);
+        // refill the buffer only when everything has been parsed
+        if (input.empty() && (pClient_->recv() <= 0)) {
+            std::cerr << "Error: connection closed by the server!\n";
+            parser_.reset();
+            return -1;
+        }
 
-        // retrieve the size of the data
-        pClient_->recv(buffer, sizeof(std::uint16_t));
-        std::uint16_t* p = reinterpret_cast<std::uint16_t*>(buffer);
+        // parse the data from memory
+        input.consume(parser_.parse(input.data(), input.size()));
 
-        int size{0};
-        while (*p > 0) {
+        if (parser_.isError()) {
+            std::cerr << "Error: invalid frame received!\n";
+            // purge the buffer
+            input.clear();
+            parser_.reset();
+            return -1;
+        }
 
-            // -1 to account for the '\0'
-            if (*p > Constants::Network::Protocol::max_read_buffer) {
-                size = Constants::Network::Protocol::max_read_buffer - 1;
+        // print the blocks already received
+        VM::queue_t& items = parser_.items();
+        while (!items.empty())
+        {
+            auto* item = items.front();
+            if (multi) {
+                results.append(reinterpret_cast<char*>(item->pdata), item->szdata);
             } else {
-                size = *p;
+                std::cout.write(reinterpret_cast<char*>(item->pdata), item->szdata);
             }
 
-            // read the data and print it on screen
-            memset(buffer, 0, Constants::Network::Protocol::max_read_buffer);
-            n = pClient_->recv(buffer, size);
-            std::cout << buffer;
-
-            // decrease the initial size by the amount read
-            *p = *p - n;
+            items.pop();
         }
     }
 
+    // the result is in the header of the last frame (an empty value has no item)
+    VM::Opcodes_t op = parser_.opcode();
+
+    // ready for the next response
+    parser_.reset();
+
+    if (multi && (op == VM::Opcodes_t::R_VALUE))
+        return printResults(results);
+
+    // the whole command failed
+    if (multi) {
+        std::cout << results;
+    }
+
     // print the last line
     std::cout << std::endl;
 
@@ -356,4 +521,125 @@ int KVClient::recv()
     } else {
         return 0;
     }
+}
+
+// print the result of each key of a command on several keys, one per line
+// return -1 if one of them is an error
+int KVClient::printResults(std::string_view results)
+{
+    int retval{0};
+
+    while (!results.empty())
+    {
+        std::uint8_t code{0};
+        std::uint32_t size{0};
+        if (results.size() < sizeof(code) + sizeof(size)) {
+            std::cerr << "Error: invalid results received!\n";
+            return -1;
+        }
+
+        memcpy(&code, results.data(), sizeof(code));
+        memcpy(&size, results.data() + sizeof(code), sizeof(size));
+        results.remove_prefix(sizeof(code) + sizeof(size));
+        if (results.size() < size) {
+            std::cerr << "Error: invalid results received!\n";
+            return -1;
+        }
+
+        if (static_cast<VM::Opcodes_t>(code) == VM::Opcodes_t::R_ERROR) {
+            retval = -1;
+        }
+        std::cout << results.substr(0, size) << '\n';
+        results.remove_prefix(size);
+    }
+    std::cout.flush();
+
+    return retval;
+}
+
+// execute the commands read from STDIN, one per line, on the same connection
+// a line is "<command> <key> [value]" where the value spans to the end of the line
+// the commands are pipelined: they are sent without waiting for the responses,
+// which are read once the window is full (half of it) or STDIN has nothing more
+int KVClient::batch()
+{
+    int retval{0};
+    int pending{0};
+    std::string line;
+
+    // let the stream buffer STDIN so in_avail() reports what is left
+    std::ios::sync_with_stdio(false);
+
+    batch_ = true;
+    while (std::getline(std::cin, line))
+    {
+        std::vector<std::string> tokens;
+        std::size_t pos{0};
+        bool multi{false};
+        std::size_t words{2};
+
+        // split the command and the key, the remaining is the value
+        // (the expected value of cas is a word, all the words are keys and values
+        // for a command on several keys)
+        while ((multi || (tokens.size() < words)) && (pos < line.size()))
+        {
+            std::size_t start = line.find_first_not_of(" \t", pos);
+            if (start == std::string::npos)
+                break;
+
+            pos = line.find_first_of(" \t", start);
+            if (pos == std::string::npos)
+                pos = line.size();
+            tokens.push_back(line.substr(start, pos - start));
+            multi = (tokens[0] == "mget") || (tokens[0] == "mset") || (tokens[0] == "mdel");
+            words = (tokens[0] == "cas") ? 3 : 2;
+        }
+
+        // skip empty lines
+        if (tokens.empty())
+            continue;
+
+        if (!multi && (pos < line.size()))
+            tokens.push_back(line.substr(pos + 1));
+
+        Application::CmdLine::Args_t args(tokens.begin(), tokens.end());
+        if (parse(args)) {
+            queue();
+            pending++;
+        } else {
+            retval = -1;
+        }
+
+        // keep queuing while the next commands are already available
+        bool available = isInputAvailable();
+        if ((pending < Constants::KVClient::pipeline_window) && available)
+            continue;
+
+        // send the commands and read the oldest responses, all of them if
+        // waiting for the user (the server sends them in the order of the commands)
+        flush();
+        int keep = available ? (Constants::KVClient::pipeline_window / 2) : 0;
+        for (; pending > keep; --pending) {
+            if (recv() != 0)
+                retval = -1;
+        }
+    }
+
+    flush();
+    for (; pending > 0; --pending) {
+        if (recv() != 0)
+            retval = -1;
+    }
+
+    return retval;
+}
+
+// some commands can be read from STDIN without blocking
+bool KVClient::isInputAvailable()
+{
+    if (std::cin.rdbuf()->in_avail() > 0)
+        return true;
+
+    struct pollfd pfd{fileno(stdin), POLLIN, 0};
+    return poll(&pfd, 1, 0) > 0;
 }
\ No newline at end of file
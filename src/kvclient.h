@@ -11,20 +11,29 @@
 // ----- includes
 #include "application.h"
 #include "network.h"
+#include "vm/arena.h"
 #include "vm/defines.h"
+#include "vm/helpers.h"
+#include "vm/parser.h"
 
+#include <deque>
 #include <string>
+#include <string_view>
 
 // ----- class
 class KVClient
 {
 public:     //< public methods
-    KVClient(std::string address, std::string port);
+    KVClient(std::string address, std::string port, std::string socket);
     ~KVClient();
 
-    void parse(Application::CmdLine& cmdline);
-    void send();
+    bool parse(Application::CmdLine& cmdline);
+    bool parse(const Application::CmdLine::Args_t& args);
+    void send();                    //< send the command and wait for nothing
+    void queue();                   //< add the command to the output list (pipelining)
+    void flush();                   //< send all the commands queued so far
     int recv();
+    int batch();
     void setUser(int uid, int gid);
 
     // no copy semantics
@@ -36,16 +45,26 @@ public:     //< public methods
     KVClient& operator=(KVClient&&) = delete;
 
 private:    //< private methods
+    void freeItems();
     void itemFromArg(std::string_view, VM::Opcodes_t);
     void getKeyName(std::string_view);
     void getValue(std::string_view);
+    bool isInputAvailable();        //< STDIN can be read without blocking
+    int printResults(std::string_view results);     //< one line per key (MGET, MSET, MDEL)
 
 private:    //< private members
     Network::TCPClient* pClient_;
+    VM::Arena arena_;               //< memory of the frames waiting to be sent
     VM::queue_t items_;
+    VM::Parser parser_;
+    Network::Output output_;        //< frames waiting to be sent
+    std::deque<VM::Opcodes_t> pending_;     //< commands waiting for their response, in order
 
     int uid_{};
     int gid_{};
+
+    bool batch_{false};     //< commands are read from STDIN
+
 };
 
 
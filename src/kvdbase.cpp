@@ -4,23 +4,54 @@
  */
 
 // ----- includes
+#include "constants.h"
 #include "kvdbase.h"
 
+#include <strings.h>
+
+#include <ctime>
 #include <filesystem>
+#include <initializer_list>
 #include <iostream>
 
+// ----- functions
+namespace
+{
+    // reset a cached statement once used
+    // a SELECT not reset would keep its read transaction (and the WAL) open
+    class ResetGuard
+    {
+    public:
+        ResetGuard(SQLite::Statement& statement) : statement_{statement} { }
+        ~ResetGuard() {
+            try {
+                statement_.reset();
+            } catch (std::exception& e) {
+                // the error has already been reported by the execution
+            }
+        }
+
+    private:
+        SQLite::Statement& statement_;
+    };
+}
+
+
 // ----- class
 
 // constructor
-KVDbase::KVDbase(std::string dbname) :
-    pSQLite_{nullptr}
+KVDbase::KVDbase(std::string dbname, int readers, DBSettings settings) :
+    settings_{settings}, pSQLite_{nullptr}, transaction_{false}, statements_{}, readers_{}, next_reader_{0}
 {
+    checkSettings();
+
     // check if the database already exists
     if (std::filesystem::exists(std::filesystem::path{dbname})) {
         // open the DB without creating it
         try {
             std::cout << "Using database [" << dbname << "]\n";
             pSQLite_ = new SQLite::Database(dbname, SQLite::OPEN_READWRITE);
+            migrateTables();
         } catch (std::exception& e) {
             std::cerr << "Error: " << e.what() << "\n";
             std::exit(EXIT_FAILURE);
@@ -37,11 +68,39 @@ KVDbase::KVDbase(std::string dbname) :
             std::exit(EXIT_FAILURE);
         }
     }
+
+    // the journal mode is stored in the database, the rest is per connection
+    try {
+        configure(*pSQLite_);
+        pSQLite_->exec("PRAGMA synchronous = " + settings_.synchronous);
+
+        std::string mode = pSQLite_->execAndGet("PRAGMA journal_mode = " + settings_.journal_mode).getString();
+        if (strcasecmp(mode.c_str(), settings_.journal_mode.c_str()) != 0) {
+            std::cerr << "Warning: journal mode " << settings_.journal_mode << " not available, using " << mode << "\n";
+        }
+    } catch (std::exception& e) {
+        std::cerr << "Error: unable to configure the database\n";
+        std::cerr << e.what() << "\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    openReaders(dbname, readers);
 }
 
 // destructor
-KVDbase::~KVDbase()
+/*virtual*/ KVDbase::~KVDbase()
 {
+    for (auto* reader : readers_) {
+        delete reader;
+    }
+    readers_.clear();
+
+    // the statements must be finalized before the connection is closed
+    for (auto& it : statements_) {
+        delete it.second;
+    }
+    statements_.clear();
+
     if (pSQLite_) {
         delete pSQLite_;
         pSQLite_ = nullptr;
@@ -54,6 +113,81 @@ SQLite::Database& KVDbase::get()
     return *pSQLite_;
 }
 
+// exit if a setting would not be understood by SQLite
+// (the values are written in the PRAGMA statements)
+void KVDbase::checkSettings()
+{
+    auto check = [](const std::string& name, const std::string& value, std::initializer_list<const char*> allowed) {
+        for (auto* mode : allowed) {
+            if (strcasecmp(value.c_str(), mode) == 0)
+                return;
+        }
+        std::cerr << "Error: invalid database " << name << " [" << value << "]\n";
+        std::exit(EXIT_FAILURE);
+    };
+
+    check("journal_mode", settings_.journal_mode, {"DELETE", "TRUNCATE", "PERSIST", "MEMORY", "WAL", "OFF"});
+    check("synchronous", settings_.synchronous, {"OFF", "NORMAL", "FULL", "EXTRA"});
+    check("temp_store", settings_.temp_store, {"DEFAULT", "FILE", "MEMORY"});
+}
+
+// apply the settings of a connection (reader or writer)
+void KVDbase::configure(SQLite::Database& db)
+{
+    db.setBusyTimeout(settings_.busy_timeout);
+    db.exec("PRAGMA mmap_size = " + std::to_string(settings_.mmap_size));
+    db.exec("PRAGMA cache_size = " + std::to_string(settings_.cache_size));
+    db.exec("PRAGMA temp_store = " + settings_.temp_store);
+}
+
+// open the read-only connections
+// in WAL mode the readers don't block the writer (and vice versa)
+void KVDbase::openReaders(std::string dbname, int readers)
+{
+    try {
+        for (int i = 0; i < readers; ++i) {
+            Reader* reader = new Reader{};
+            reader->pSQLite = new SQLite::Database(dbname, SQLite::OPEN_READONLY);
+            configure(*reader->pSQLite);
+            readers_.push_back(reader);
+        }
+    } catch (std::exception& e) {
+        std::cerr << "Error: unable to open the read connections\n";
+        std::cerr << e.what() << "\n";
+        std::exit(EXIT_FAILURE);
+    }
+}
+
+// lock a read connection, preferably one not already in use
+KVDbase::Reader* KVDbase::acquireReader()
+{
+    std::size_t count = readers_.size();
+    std::size_t first = next_reader_++ % count;
+
+    for (std::size_t i = 0; i < count; ++i) {
+        Reader* reader = readers_[(first + i) % count];
+        if (reader->mutex.try_lock())
+            return reader;
+    }
+
+    // all the readers are busy: wait for one
+    Reader* reader = readers_[first];
+    reader->mutex.lock();
+    return reader;
+}
+
+// return the statement compiled for a connection, ready to be bound
+SQLite::Statement& KVDbase::prepare(SQLite::Database& db, Statements& statements, std::string_view sql)
+{
+    auto it = statements.find(sql);
+    if (it != statements.end())
+        return *it->second;
+
+    SQLite::Statement* statement = new SQLite::Statement(db, std::string(sql));
+    statements[sql] = statement;
+    return *statement;
+}
+
 // create the initial tables
 void KVDbase::createTables()
 {
@@ -62,6 +196,8 @@ void KVDbase::createTables()
         return;
 
     try {
+        // the page size can't be changed once the first table is created
+        pSQLite_->exec("PRAGMA page_size = " + std::to_string(settings_.page_size));
         pSQLite_->exec("DROP TABLE IF EXISTS KVEntry");
         pSQLite_->exec("CREATE TABLE KVEntry ("
             "id INTEGER PRIMARY KEY AUTOINCREMENT,"
@@ -72,6 +208,9 @@ void KVDbase::createTables()
             "timestamp INTEGER"
             ")"
             );
+        pSQLite_->exec("CREATE UNIQUE INDEX KVEntry_user_key ON KVEntry (user, key)");
+        pSQLite_->exec("CREATE INDEX KVEntry_expiry ON KVEntry (expiry) WHERE expiry IS NOT NULL");
+        pSQLite_->exec("PRAGMA user_version = " + std::to_string(Constants::Database::schema_version));
     } catch (std::exception& e) {
         std::cerr << "Error: unable to create the table in the database\n";
         std::cerr << e.what() << "\n";
@@ -79,15 +218,108 @@ void KVDbase::createTables()
     }
 }
 
+// upgrade the tables of an existing database to the current schema
+void KVDbase::migrateTables()
+{
+    // ensure we have an object before moving forward
+    if (!pSQLite_)
+        return;
+
+    try {
+        int version = pSQLite_->execAndGet("PRAGMA user_version").getInt();
+        if (version >= Constants::Database::schema_version)
+            return;
+
+        std::cout << "Migrating database to schema version " << Constants::Database::schema_version << "\n";
+        SQLite::Transaction transaction(*pSQLite_);
+
+        // version 1: unique (user, key) index, only the latest duplicate is kept
+        if (version < 1) {
+            pSQLite_->exec("DELETE FROM KVEntry WHERE id NOT IN (SELECT MAX(id) FROM KVEntry GROUP BY user, key)");
+            pSQLite_->exec("CREATE UNIQUE INDEX IF NOT EXISTS KVEntry_user_key ON KVEntry (user, key)");
+        }
+
+        // version 2: partial index of the expiries, for the purge
+        if (version < 2) {
+            pSQLite_->exec("CREATE INDEX IF NOT EXISTS KVEntry_expiry ON KVEntry (expiry) WHERE expiry IS NOT NULL");
+        }
+
+        pSQLite_->exec("PRAGMA user_version = " + std::to_string(Constants::Database::schema_version));
+        transaction.commit();
+    } catch (std::exception& e) {
+        std::cerr << "Error: unable to migrate the database\n";
+        std::cerr << e.what() << "\n";
+        std::exit(EXIT_FAILURE);
+    }
+}
+
 // retrieve a single row from the database
-DBResult* KVDbase::fetchRow(std::uint8_t* key, int size,  int uid)
+/*virtual*/ DBResult* KVDbase::get(const std::uint8_t* key, int ksize, int uid)
+{
+    Reader* reader = acquireReader();
+    std::lock_guard<std::mutex> lock(reader->mutex, std::adopt_lock);
+    return read(*reader->pSQLite, reader->statements, key, ksize, uid);
+}
+
+// retrieve several rows in a single read transaction (the same snapshot of the database)
+/*virtual*/ void KVDbase::getMany(const Storage::Key* keys, int count, DBResult** results)
+{
+    Reader* reader = acquireReader();
+    std::lock_guard<std::mutex> lock(reader->mutex, std::adopt_lock);
+    bool transaction{false};
+
+    try
+    {
+        SQLite::Statement& query = prepare(*reader->pSQLite, reader->statements, "BEGIN");
+        ResetGuard guard{query};
+        query.exec();
+        transaction = true;
+    }
+    catch(const std::exception& e)
+    {
+        // the rows will be read one by one
+        std::cerr << e.what() << '\n';
+    }
+
+    for (int i = 0; i < count; ++i) {
+        const Storage::Key& key = keys[i];
+        results[i] = read(*reader->pSQLite, reader->statements, reinterpret_cast<const std::uint8_t*>(key.key.data()), key.key.size(), key.uid);
+    }
+
+    if (!transaction)
+        return;
+
+    try
+    {
+        SQLite::Statement& query = prepare(*reader->pSQLite, reader->statements, "COMMIT");
+        ResetGuard guard{query};
+        query.exec();
+    }
+    catch(const std::exception& e)
+    {
+        std::cerr << e.what() << '\n';
+    }
+}
+
+// retrieve a single row with the write connection, inside the transaction of the batch
+/*virtual*/ DBResult* KVDbase::getForUpdate(const std::uint8_t* key, int ksize, int uid)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    return read(*pSQLite_, statements_, key, ksize, uid);
+}
+
+// retrieve a single row with a connection
+DBResult* KVDbase::read(SQLite::Database& db, Statements& statements, const std::uint8_t* key, int ksize, int uid)
 {
     try
     {
         // prepare the query
-        SQLite::Statement query(*pSQLite_, "SELECT value FROM KVEntry WHERE user = :uid AND key = :key");
+        SQLite::Statement& query = prepare(db, statements, "SELECT value, expiry FROM KVEntry WHERE user = :uid AND key = :key "
+                                                           "AND (expiry IS NULL OR expiry > :now)");
+        ResetGuard guard{query};
         query.bind(":uid", uid);
-        query.bind(":key", key, size);
+        query.bindNoCopy(":key", key, ksize);
+        query.bind(":now", static_cast<std::int64_t>(std::time(nullptr)));
 
         // execute the query
         bool result = query.executeStep();
@@ -99,9 +331,11 @@ DBResult* KVDbase::fetchRow(std::uint8_t* key, int size,  int uid)
         int size = blob.getBytes();
 
         // create a new result structure
+        SQLite::Column expiry = query.getColumn(1);
         DBResult* db_result = new DBResult{
             size: size,
-            pData: new std::uint8_t[size]
+            pData: new std::uint8_t[size],
+            expiry: expiry.isNull() ? 0 : expiry.getInt64()
         };
 
         // copy the blob
@@ -117,61 +351,50 @@ DBResult* KVDbase::fetchRow(std::uint8_t* key, int size,  int uid)
     return nullptr;
 }
 
-// add a key/value in the database
-int KVDbase::insert(std::uint8_t* key, int ksize, std::uint8_t* value, int vsize, int uid)
+// add a key/value in the database (or replace the value of the key)
+// the key and the value are bound without a copy, they outlive the statement
+/*virtual*/ bool KVDbase::set(const std::uint8_t* key, int ksize, const std::uint8_t* value, int vsize, int uid)
 {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     int rows{0};
 
     try
     {
-        // check if the row does not exist already
-        SQLite::Statement squery(*pSQLite_, "SELECT * FROM KVEntry WHERE user = :uid AND key = :key");
-        squery.bind(":uid", uid);
-        squery.bind(":key", key, ksize);
-
-        bool result = squery.executeStep();
-        if (!result)
-        {
-            // the record does not exist, create one
-            SQLite::Statement iquery(*pSQLite_, "INSERT INTO KVEntry (user, key, value) VALUES (:uid, :key, :value)");
+        // a single lookup in the (user, key) index
+        SQLite::Statement& query = prepare(*pSQLite_, statements_, "INSERT INTO KVEntry (user, key, value) VALUES (:uid, :key, :value) "
+                                                                   "ON CONFLICT (user, key) DO UPDATE SET value = excluded.value, expiry = NULL");
+        ResetGuard guard{query};
 
-            iquery.bind(":uid", uid);
-            iquery.bind(":key", key, ksize);
-            iquery.bind(":value", value, vsize);
-
-            rows = iquery.exec();
-        }
-        else
-        {
-            // update the current record
-            SQLite::Statement uquery(*pSQLite_, "UPDATE KVEntry SET value = :value WHERE user = :uid AND key = :key");
-
-            uquery.bind(":uid", uid);
-            uquery.bind(":key", key, ksize);
-            uquery.bind(":value", value, vsize);
+        query.bind(":uid", uid);
+        query.bindNoCopy(":key", key, ksize);
+        query.bindNoCopy(":value", value, vsize);
 
-            rows = uquery.exec();
-        }
+        rows = query.exec();
     }
     catch(const std::exception& e)
     {
         std::cerr << e.what() << '\n';
     }
 
-    return rows;
+    return (rows != 0);
 }
 
 // check if a key exists in the database
-bool KVDbase::exists(std::uint8_t* key, int ksize, int uid)
+/*virtual*/ bool KVDbase::exists(const std::uint8_t* key, int ksize, int uid)
 {
+    Reader* reader = acquireReader();
+    std::lock_guard<std::mutex> lock(reader->mutex, std::adopt_lock);
     try
     {
         // check if the row does not exist already
-        SQLite::Statement squery(*pSQLite_, "SELECT * FROM KVEntry WHERE user = :uid AND key = :key");
-        squery.bind(":uid", uid);
-        squery.bind(":key", key, ksize);
+        SQLite::Statement& query = prepare(*reader->pSQLite, reader->statements, "SELECT 1 FROM KVEntry WHERE user = :uid AND key = :key "
+                                                                                 "AND (expiry IS NULL OR expiry > :now)");
+        ResetGuard guard{query};
+        query.bind(":uid", uid);
+        query.bindNoCopy(":key", key, ksize);
+        query.bind(":now", static_cast<std::int64_t>(std::time(nullptr)));
 
-        return squery.executeStep();
+        return query.executeStep();
     }
     catch(const std::exception& e)
     {
@@ -182,16 +405,45 @@ bool KVDbase::exists(std::uint8_t* key, int ksize, int uid)
 }
 
 
-bool KVDbase::remove(std::uint8_t* key, int ksize, int uid)
+// delete a key from the database
+/*virtual*/ bool KVDbase::remove(const std::uint8_t* key, int ksize, int uid)
 {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     int rows{0};
 
     try
     {
         // check if the row does not exist already
-        SQLite::Statement query(*pSQLite_, "DELETE FROM KVEntry WHERE user = :uid AND key = :key");
+        SQLite::Statement& query = prepare(*pSQLite_, statements_, "DELETE FROM KVEntry WHERE user = :uid AND key = :key");
+        ResetGuard guard{query};
+        query.bind(":uid", uid);
+        query.bindNoCopy(":key", key, ksize);
+
+        rows = query.exec();
+    }
+    catch(const std::exception& e)
+    {
+        std::cerr << e.what() << '\n';
+    }
+
+    return (rows != 0);
+}
+
+// set the expiry of a key (NULL: no expiry)
+/*virtual*/ bool KVDbase::expire(const std::uint8_t* key, int ksize, int uid, std::int64_t deadline)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    int rows{0};
+
+    try
+    {
+        SQLite::Statement& query = prepare(*pSQLite_, statements_, "UPDATE KVEntry SET expiry = NULLIF(:deadline, 0) WHERE user = :uid AND key = :key "
+                                                                   "AND (expiry IS NULL OR expiry > :now)");
+        ResetGuard guard{query};
+        query.bind(":deadline", deadline);
         query.bind(":uid", uid);
-        query.bind(":key", key, ksize);
+        query.bindNoCopy(":key", key, ksize);
+        query.bind(":now", static_cast<std::int64_t>(std::time(nullptr)));
 
         rows = query.exec();
     }
@@ -202,3 +454,166 @@ bool KVDbase::remove(std::uint8_t* key, int ksize, int uid)
 
     return (rows != 0);
 }
+
+// list the keys of a user starting with the prefix
+// the keys are read in order from the (user, key) index, from the prefix
+// until the first key not starting with it
+/*virtual*/ void KVDbase::scan(const std::uint8_t* prefix, int psize, int uid, Storage::ScanCallback callback)
+{
+    Reader* reader = acquireReader();
+    std::lock_guard<std::mutex> lock(reader->mutex, std::adopt_lock);
+    try
+    {
+        SQLite::Statement& query = prepare(*reader->pSQLite, reader->statements, "SELECT key, expiry FROM KVEntry WHERE user = :uid AND key >= :prefix "
+                                                                                 "ORDER BY key");
+        ResetGuard guard{query};
+        query.bind(":uid", uid);
+        query.bindNoCopy(":prefix", prefix, psize);
+        std::int64_t now = std::time(nullptr);
+
+        while (query.executeStep())
+        {
+            SQLite::Column column = query.getColumn(0);
+            const std::uint8_t* key = static_cast<const std::uint8_t*>(column.getBlob());
+            int ksize = column.getBytes();
+
+            if ((ksize < psize) || (memcmp(key, prefix, psize) != 0))
+                break;
+
+            SQLite::Column expiry = query.getColumn(1);
+            if (!expiry.isNull() && (expiry.getInt64() <= now))
+                continue;
+
+            if (!callback(key, ksize))
+                break;
+        }
+    }
+    catch(const std::exception& e)
+    {
+        std::cerr << e.what() << '\n';
+    }
+}
+
+// list the keys of a user in order, after a key
+// the statement is stepped until the callback stops: the rows are never gathered
+/*virtual*/ void KVDbase::list(const std::uint8_t* after, int asize, int uid, Storage::ScanCallback callback)
+{
+    Reader* reader = acquireReader();
+    std::lock_guard<std::mutex> lock(reader->mutex, std::adopt_lock);
+    try
+    {
+        std::string_view sql = (after != nullptr)
+            ? "SELECT key FROM KVEntry WHERE user = :uid AND key > :after AND (expiry IS NULL OR expiry > :now) ORDER BY key"
+            : "SELECT key FROM KVEntry WHERE user = :uid AND (expiry IS NULL OR expiry > :now) ORDER BY key";
+        SQLite::Statement& query = prepare(*reader->pSQLite, reader->statements, sql);
+        ResetGuard guard{query};
+        query.bind(":uid", uid);
+        if (after != nullptr) {
+            query.bindNoCopy(":after", after, asize);
+        }
+        query.bind(":now", static_cast<std::int64_t>(std::time(nullptr)));
+
+        while (query.executeStep())
+        {
+            SQLite::Column column = query.getColumn(0);
+            if (!callback(static_cast<const std::uint8_t*>(column.getBlob()), column.getBytes()))
+                break;
+        }
+    }
+    catch(const std::exception& e)
+    {
+        std::cerr << e.what() << '\n';
+    }
+}
+
+// delete the keys expired at now, the oldest first
+// the expired rows are found with the partial index of the expiries
+/*virtual*/ int KVDbase::purge(std::int64_t now, int limit, Storage::PurgeCallback callback)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    int count{0};
+
+    try
+    {
+        std::vector<std::int64_t> ids;
+        {
+            SQLite::Statement& query = prepare(*pSQLite_, statements_, "SELECT id, user, key FROM KVEntry WHERE expiry <= :now "
+                                                                       "ORDER BY expiry LIMIT :limit");
+            ResetGuard guard{query};
+            query.bind(":now", now);
+            query.bind(":limit", limit);
+
+            while (query.executeStep())
+            {
+                SQLite::Column key = query.getColumn(2);
+                ids.push_back(query.getColumn(0).getInt64());
+                callback(query.getColumn(1).getInt(), static_cast<const std::uint8_t*>(key.getBlob()), key.getBytes());
+            }
+        }
+
+        SQLite::Statement& query = prepare(*pSQLite_, statements_, "DELETE FROM KVEntry WHERE id = :id");
+        for (auto id : ids)
+        {
+            ResetGuard guard{query};
+            query.bind(":id", id);
+            count += query.exec();
+        }
+    }
+    catch(const std::exception& e)
+    {
+        std::cerr << e.what() << '\n';
+    }
+
+    return count;
+}
+
+// start a transaction, the lock is kept until commit()
+/*virtual*/ void KVDbase::begin()
+{
+    mutex_.lock();
+
+    try
+    {
+        // take the write lock now rather than on the first write
+        SQLite::Statement& query = prepare(*pSQLite_, statements_, "BEGIN IMMEDIATE");
+        ResetGuard guard{query};
+        query.exec();
+        transaction_ = true;
+    }
+    catch(const std::exception& e)
+    {
+        // the writes will be committed one by one
+        std::cerr << e.what() << '\n';
+    }
+}
+
+// commit the writes since begin() and release the lock
+/*virtual*/ bool KVDbase::commit()
+{
+    bool result{true};
+
+    if (transaction_)
+    {
+        try
+        {
+            SQLite::Statement& query = prepare(*pSQLite_, statements_, "COMMIT");
+            ResetGuard guard{query};
+            query.exec();
+        }
+        catch(const std::exception& e)
+        {
+            std::cerr << e.what() << '\n';
+            result = false;
+
+            try {
+                pSQLite_->exec("ROLLBACK");
+            } catch (const std::exception&) {
+                // the transaction has already been rolled back by SQLite
+            }
+        }
+        transaction_ = false;
+    }
+
+    mutex_.unlock();
+    return result;
+}
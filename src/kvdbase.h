@@ -8,36 +8,59 @@
 #define KVDBASE_H
 
 // ----- includes
+#include "storage/engine.h"
+
 #include <SQLiteCpp/SQLiteCpp.h>
 
+#include <atomic>
+#include <cstdint>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
 
 
 // ----- structures
-struct DBResult
-{
-    int size;
-    std::uint8_t* pData;
 
-    ~DBResult() {
-        delete [] pData;
-    }
+// SQLite tuning applied when the connections are opened
+struct DBSettings
+{
+    std::string journal_mode;       //< DELETE, TRUNCATE, PERSIST, MEMORY, WAL or OFF
+    std::string synchronous;        //< OFF, NORMAL, FULL or EXTRA
+    std::int64_t mmap_size;         //< bytes of the file mapped in memory (0: disabled)
+    std::int64_t cache_size;        //< page cache in pages, in KiB if negative
+    int page_size;                  //< only applied to a new database
+    int busy_timeout;               //< wait for a lock in ms
+    std::string temp_store;         //< DEFAULT, FILE or MEMORY
 };
 
 // ----- class
-class KVDbase
+
+// storage engine on a SQLite database
+class KVDbase : public Storage::Engine
 {
 public:     //< public methods
-    KVDbase(std::string dbname);
-    ~KVDbase();
+    KVDbase(std::string dbname, int readers, DBSettings settings);
+    virtual ~KVDbase();
 
     SQLite::Database& get();
 
     // operations
-    DBResult* fetchRow(std::uint8_t* key, int size, int uid);
-    int insert(std::uint8_t* key, int ksize, std::uint8_t* value, int vsize, int uid);
-    bool exists(std::uint8_t* key, int ksize, int uid);
-    bool remove(std::uint8_t* key, int ksize, int uid);
+    DBResult* get(const std::uint8_t* key, int ksize, int uid) override;
+    bool set(const std::uint8_t* key, int ksize, const std::uint8_t* value, int vsize, int uid) override;
+    bool exists(const std::uint8_t* key, int ksize, int uid) override;
+    bool remove(const std::uint8_t* key, int ksize, int uid) override;
+    void getMany(const Storage::Key* keys, int count, DBResult** results) override;
+    DBResult* getForUpdate(const std::uint8_t* key, int ksize, int uid) override;
+    bool expire(const std::uint8_t* key, int ksize, int uid, std::int64_t deadline) override;
+    void scan(const std::uint8_t* prefix, int psize, int uid, Storage::ScanCallback callback) override;
+    void list(const std::uint8_t* after, int asize, int uid, Storage::ScanCallback callback) override;
+    int purge(std::int64_t now, int limit, Storage::PurgeCallback callback) override;
+
+    // the writes of a batch are grouped in a single transaction (group commit)
+    void begin() override;
+    bool commit() override;
 
 
     // no copy
@@ -48,12 +71,48 @@ public:     //< public methods
     KVDbase(KVDbase&&) = delete;
     KVDbase& operator=(KVDbase&&) = delete;
 
+private:    //< private types
+    // statements compiled once per connection, identified by their SQL text (a string literal)
+    using Statements = std::unordered_map<std::string_view, SQLite::Statement*>;
+
+    // read-only connection, several readers can run concurrently (WAL)
+    struct Reader
+    {
+        SQLite::Database* pSQLite;
+        std::mutex mutex;
+        Statements statements;
+
+        ~Reader() {
+            // the statements must be finalized before the connection is closed
+            for (auto& it : statements) {
+                delete it.second;
+            }
+            delete pSQLite;
+        }
+    };
+
 private:    //< private methods
     void createTables();
+    void migrateTables();           //< upgrade an existing database to the current schema
+    void openReaders(std::string dbname, int readers);
+    void checkSettings();                       //< exit if a setting is not a valid SQLite value
+    void configure(SQLite::Database& db);       //< apply the settings of every connection
+    Reader* acquireReader();        //< lock a free read connection
+    // the connection must be locked
+    DBResult* read(SQLite::Database& db, Statements& statements, const std::uint8_t* key, int ksize, int uid);
+
+    // return the cached statement of a connection (compiled on first use)
+    SQLite::Statement& prepare(SQLite::Database& db, Statements& statements, std::string_view sql);
 
 
 private:    //< private members
-    SQLite::Database* pSQLite_;
+    DBSettings settings_;
+    SQLite::Database* pSQLite_;     //< the only connection allowed to write
+    std::recursive_mutex mutex_;    //< the writes are serialized (held during a transaction)
+    bool transaction_;              //< a transaction groups the writes
+    Statements statements_;         //< statements of the write connection
+    std::vector<Reader*> readers_;  //< read-only connections
+    std::atomic<unsigned> next_reader_;
 };
 
 #endif // KVDBASE_H
@@ -0,0 +1,164 @@
+/*
+ * @file    kvpattern.cpp
+ * @brief   Source for the KVPattern and KVPatterns classes
+ */
+
+// ----- includes
+#include "constants.h"
+#include "kvpattern.h"
+
+#include <cstring>
+
+
+// ----- functions
+namespace
+{
+    // characters with a meaning in an ECMAScript pattern
+    bool isSpecial(char c)
+    {
+        return (c != '\0') && (std::strchr(".^$|?*+()[]{}\\", c) != nullptr);
+    }
+
+    // an unescaped alternation: the branches may not share the prefix
+    bool hasAlternation(std::string_view pattern)
+    {
+        for (std::size_t i = 0; i < pattern.size(); ++i) {
+            if (pattern[i] == '\\') {
+                ++i;
+            } else if (pattern[i] == '|') {
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+
+// ----- class KVPattern
+
+// constructor
+KVPattern::KVPattern(std::string_view pattern) :
+    prefix_{}, regex_{}, any_{false}, exact_{false}
+{
+    std::size_t length = extractPrefix(pattern, prefix_);
+    std::string_view remainder = pattern.substr(length);
+    any_ = (remainder == ".*") || (remainder == ".*$");
+    exact_ = remainder.empty() || (remainder == "$");
+
+    // the whole pattern is compiled: the prefix may be followed by a quantifier
+    if (!any_ && !exact_) {
+        regex_.assign(pattern.data(), pattern.size(), std::regex::ECMAScript | std::regex::optimize);
+    }
+}
+
+// return the literal prefix of the pattern
+const std::string& KVPattern::prefix() const
+{
+    return prefix_;
+}
+
+// check if the whole key matches the pattern (the prefix is already checked by the scan)
+bool KVPattern::match(const std::uint8_t* key, int ksize) const
+{
+    if (any_)
+        return true;
+
+    if (exact_)
+        return (static_cast<std::size_t>(ksize) == prefix_.size());
+
+    const char* first = reinterpret_cast<const char*>(key);
+    return std::regex_match(first, first + ksize, regex_);
+}
+
+// extract the literal characters at the start of the pattern
+// a character followed by a quantifier is optional: the prefix stops before it
+/*static*/ std::size_t KVPattern::extractPrefix(std::string_view pattern, std::string& prefix)
+{
+    std::size_t i{0};
+
+    if (hasAlternation(pattern))
+        return 0;
+
+    // the pattern is matched against the whole key anyway
+    if (!pattern.empty() && (pattern[0] == '^')) {
+        i = 1;
+    }
+
+    while (i < pattern.size())
+    {
+        // an escaped character class (\d, \w...) ends the prefix
+        char c = pattern[i];
+        std::size_t length{1};
+        if (c == '\\') {
+            if ((i + 1 >= pattern.size()) || !isSpecial(pattern[i + 1]))
+                break;
+            c = pattern[i + 1];
+            length = 2;
+        } else if (isSpecial(c)) {
+            break;
+        }
+
+        char next = (i + length < pattern.size()) ? pattern[i + length] : '\0';
+        if ((next == '*') || (next == '?') || (next == '{'))
+            break;
+
+        prefix.push_back(c);
+        i += length;
+
+        // the character is repeated: what follows is not literal anymore
+        if (next == '+')
+            break;
+    }
+
+    return i;
+}
+
+
+// ----- class KVPatterns
+
+// constructor
+KVPatterns::KVPatterns() :
+    mutex_{}, entries_{}, index_{}
+{ }
+
+// destructor
+KVPatterns::~KVPatterns()
+{
+    index_.clear();
+    entries_.clear();
+}
+
+// return the compiled pattern, from the cache if it has been used recently
+std::shared_ptr<const KVPattern> KVPatterns::compile(std::string_view pattern)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = index_.find(pattern);
+        if (it != index_.end()) {
+            entries_.splice(entries_.begin(), entries_, it->second);
+            return it->second->second;
+        }
+    }
+
+    // the compilation is done without the lock, the readers are not blocked
+    std::shared_ptr<const KVPattern> compiled;
+    try {
+        compiled = std::make_shared<const KVPattern>(pattern);
+    } catch (const std::regex_error& e) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (index_.find(pattern) != index_.end())
+        return compiled;
+
+    entries_.emplace_front(std::string(pattern), compiled);
+    index_[entries_.front().first] = entries_.begin();
+
+    if (entries_.size() > Constants::KVServer::pattern_cache_size) {
+        index_.erase(entries_.back().first);
+        entries_.pop_back();
+    }
+
+    return compiled;
+}
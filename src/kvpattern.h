@@ -0,0 +1,81 @@
+/*
+ * @file    kvpattern.h
+ * @brief   Header for the KVPattern and KVPatterns classes
+ */
+
+// ----- guards
+#ifndef KVPATTERN_H
+#define KVPATTERN_H
+
+// ----- includes
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+
+// ----- class
+
+// regular expression matched against the whole key (ECMAScript syntax)
+// the literal prefix of the pattern is extracted to scan a range of keys,
+// the regex only filters the keys of this range
+class KVPattern
+{
+public:     //< public methods
+    KVPattern(std::string_view pattern);    //< throws std::regex_error if invalid
+
+    const std::string& prefix() const;      //< all the keys matched start with it
+    bool match(const std::uint8_t* key, int ksize) const;
+
+    // no copy semantics
+    KVPattern(const KVPattern&) = delete;
+    KVPattern& operator=(const KVPattern&) = delete;
+
+    // no move semantics
+    KVPattern(KVPattern&&) = delete;
+    KVPattern& operator=(KVPattern&&) = delete;
+
+private:    //< private methods
+    static std::size_t extractPrefix(std::string_view pattern, std::string& prefix);   //< return the length parsed
+
+private:    //< private members
+    std::string prefix_;
+    std::regex regex_;
+    bool any_;                      //< the prefix is enough (".*" after it)
+    bool exact_;                    //< the key is the prefix (nothing or "$" after it)
+};
+
+// compiled patterns shared by the readers, the least recently used is dropped
+// a pattern stays valid for the requests using it after being dropped
+class KVPatterns
+{
+public:     //< public methods
+    KVPatterns();
+    ~KVPatterns();
+
+    // nullptr if the pattern is not a valid regular expression
+    std::shared_ptr<const KVPattern> compile(std::string_view pattern);
+
+    // no copy semantics
+    KVPatterns(const KVPatterns&) = delete;
+    KVPatterns& operator=(const KVPatterns&) = delete;
+
+    // no move semantics
+    KVPatterns(KVPatterns&&) = delete;
+    KVPatterns& operator=(KVPatterns&&) = delete;
+
+private:    //< private types
+    using Entry = std::pair<std::string, std::shared_ptr<const KVPattern>>;
+
+private:    //< private members
+    std::mutex mutex_;
+    std::list<Entry> entries_;      //< most recently used first
+    std::unordered_map<std::string_view, std::list<Entry>::iterator> index_;   //< the key points to the entry
+};
+
+#endif // KVPATTERN_H
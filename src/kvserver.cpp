@@ -9,11 +9,15 @@
 #include "vm/helpers.h"
 
 #include <signal.h>
-#include <sys/socket.h>
 
+#include <algorithm>
+#include <charconv>
 #include <chrono>
+#include <ctime>
 #include <functional>
 #include <iostream>
+#include <limits>
+#include <memory>
 
 
 // ----- functions
@@ -24,26 +28,79 @@ void signalHandler(int signal)
     KVServerCallback(signal);
 }
 
+namespace
+{
+    // the cursor of a SCAN is the last key listed in hex, the next page starts after it
+    std::string encodeCursor(std::string_view key)
+    {
+        static const char digits[] = "0123456789abcdef";
+
+        std::string cursor("k");
+        for (unsigned char c : key) {
+            cursor.push_back(digits[c >> 4]);
+            cursor.push_back(digits[c & 0x0F]);
+        }
+        return cursor;
+    }
+
+    // false if the cursor has not been returned by a SCAN
+    bool decodeCursor(VM::Span cursor, std::string& key)
+    {
+        if ((cursor.size == 0) || (cursor.data[0] != 'k') || ((cursor.size % 2) == 0))
+            return false;
+
+        const char* data = reinterpret_cast<const char*>(cursor.data);
+        for (std::size_t i = 1; i < cursor.size; i += 2) {
+            std::uint8_t value{0};
+            auto [ptr, error] = std::from_chars(data + i, data + i + 2, value, 16);
+            if ((error != std::errc{}) || (ptr != data + i + 2))
+                return false;
+            key.push_back(static_cast<char>(value));
+        }
+        return true;
+    }
+}
+
 
 // ----- class
 
 // constructor
-KVServer::KVServer(std::string address, std::string port, std::string dbname) :
-    pDbase_{nullptr}, pServer_{nullptr}, done_{true}
+KVServer::KVServer(std::string address, std::string port, std::string socket, int threads, std::string backend, int workers,
+                   std::string engine, std::string dbname, DBSettings settings, CacheSettings cache) :
+    pStorage_{nullptr}, pCache_{nullptr}, pPatterns_{nullptr}, pServer_{nullptr}, pReaders_{nullptr}, pWriter_{nullptr}, done_{true}
 {
-    // create a new database instance
-    pDbase_ = new KVDbase(dbname);
-    if (!pDbase_) {
-        std::cerr << "Error: unable to create a KVDbase instance!\n";
+    // create the storage (one read connection per worker)
+    pStorage_ = createEngine(engine, dbname, workers, settings);
+    if (!pStorage_) {
+        std::cerr << "Error: unable to create a storage engine instance!\n";
         std::exit(EXIT_FAILURE);
     }
 
-    // create a new TCPServer
-    pServer_ = new Network::TCPServer{address, port};
+    // the values read the most are kept in memory (already the case with the memory engine)
+    if (engine == "memory") {
+        cache.memory = 0;
+    }
+    pCache_ = new KVCache(cache);
+    if (!pCache_) {
+        std::cerr << "Error: unable to create a KVCache instance!\n";
+        std::exit(EXIT_FAILURE);
+    }
+    pPatterns_ = new KVPatterns();
+
+    // create a new TCPServer (on a UNIX socket if a path is provided)
+    if (socket.size() != 0) {
+        pServer_ = new Network::TCPServer{socket, threads, backend};
+    } else {
+        pServer_ = new Network::TCPServer{address, port, threads, backend};
+    }
     if (!pServer_) {
         std::cerr << "Error: unable to create a TCPServer instance!\n";
         std::exit(EXIT_FAILURE);
     }
+
+    // the storage is accessed by the workers, never by the TCP threads
+    pReaders_ = new Worker::Pool{workers};
+    pWriter_ = new Worker::Pool{1};
 }
 
 // destructor
@@ -51,11 +108,24 @@ KVServer::~KVServer()
 {
     // stop properly the server
     stop();
+
+    // the workers post their responses to the reactors
+    delete pReaders_;
+    pReaders_ = nullptr;
+    delete pWriter_;
+    pWriter_ = nullptr;
+
     delete pServer_;
     pServer_ = nullptr;
 
-    // free the items in the queue if any
-    freeItems();
+    delete pCache_;
+    pCache_ = nullptr;
+
+    delete pPatterns_;
+    pPatterns_ = nullptr;
+
+    delete pStorage_;
+    pStorage_ = nullptr;
 }
 
 // start the server
@@ -67,163 +137,422 @@ void KVServer::start()
     signal(SIGINT, ::signalHandler);
 
     // set the TCPServer callback via Lambda function
-    auto fcn = [this](int sock) { this->callback(sock); };
+    auto fcn = [this](Network::Connection* conn) { this->callback(conn); };
     pServer_->setUserCallback(fcn);
 
+    // start the workers, the writes waiting are committed together
+    auto work = [this](Worker::Task* task) { this->execute(task); };
+    auto batch = [this](Worker::Task** tasks, std::size_t count) { this->executeBatch(tasks, count); };
+    pReaders_->setUserCallback(work);
+    pWriter_->setBatchCallback(batch);
+    pReaders_->start();
+    pWriter_->start();
+
     // start the TCP server
     pServer_->start();
 
     // infinite mainloop
     std::cerr << "Starting KVServer mainloop... CTRL+C to stop\n";
     done_ = false;
+    auto purged = std::chrono::steady_clock::now();
     while (!done_)
     {
         // wait for 200ms
         std::this_thread::sleep_for(Constants::KVServer::kvserver_mainloop_timeout);
+
+        // the expired keys are invisible already, their space is reclaimed here
+        if (std::chrono::steady_clock::now() - purged >= Constants::Storage::purge_interval) {
+            purgeExpired();
+            purged = std::chrono::steady_clock::now();
+        }
     }
+
+    // wait for the TCP threads from the main thread
+    stop();
+}
+
+// create the storage engine requested by the user
+Storage::Engine* KVServer::createEngine(std::string engine, std::string dbname, int readers, DBSettings settings)
+{
+    if (engine == "memory")
+        return new Storage::MemoryEngine();
+
+    // the database path is the directory of the segments
+    if (engine == "log")
+        return new Storage::LogEngine(dbname);
+
+    // the data would be lost silently with the wrong engine
+    if (engine != "sqlite") {
+        std::cerr << "Error: unknown storage engine [" << engine << "]\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    return new KVDbase(dbname, readers, settings);
+}
+
+// delete the expired keys by small transactions, the writer is not blocked for long
+void KVServer::purgeExpired()
+{
+    std::int64_t now = std::time(nullptr);
+    auto erase = [this](int uid, const std::uint8_t* key, int ksize) { pCache_->erase(key, ksize, uid); };
+    int count{0};
+
+    do
+    {
+        pStorage_->begin();
+        pCache_->begin();
+        count = pStorage_->purge(now, Constants::Storage::purge_batch, erase);
+        bool committed = pStorage_->commit();
+
+        // the cache may have missed keys restored by the rollback
+        if (!committed) {
+            pCache_->clear();
+        }
+        pCache_->end();
+
+        if (!committed)
+            break;
+    } while ((count == Constants::Storage::purge_batch) && !done_);
 }
 
 // stop the server
+// no more tasks once the TCP threads are stopped, the workers drain their queue
 void KVServer::stop()
 {
-    if (!done_) {
-        done_ = true;
-        pServer_->stop();
-    }
+    done_ = true;
+    pServer_->stop();
+    pReaders_->stop();
+    pWriter_->stop();
 }
 
 // signal handler
+// only notify the mainloop as the threads can't be joined from here
 void KVServer::signalHandler(int signal)
 {
     if (signal == SIGINT) {
-        stop();
+        done_ = true;
     }
 }
 
 // free the items in the queue (if any)
-void KVServer::freeItems()
+void KVServer::freeItems(VM::queue_t& items)
 {
-    while (items_.size() > 0) {
-        removeItem();
+    while (items.size() > 0) {
+        removeItem(items);
     }
 }
 
 // get the next item from the queue
-VM::QueueItem* KVServer::nextItem()
+VM::QueueItem* KVServer::nextItem(VM::queue_t& items)
 {
-    return items_.front();
+    return items.front();
 }
 
-// remove the item from the queue
-void KVServer::removeItem()
+// remove the item from the queue (its memory is released with the arena)
+void KVServer::removeItem(VM::queue_t& items)
 {
-    auto* item = items_.front();
-    items_.pop();
-    delete item;
+    items.pop();
 }
 
 
 // network callback
-void KVServer::callback(int sock)
+void KVServer::callback(Network::Connection* conn)
 {
-    // recreate the items
-    std::uint8_t buffer[Constants::Network::Protocol::max_read_buffer] = {0};
+    Network::Buffer& input = conn->input();
+    VM::Parser& parser = conn->parser();
+
+    // the frames are executed concurrently (pipelining), the responses
+    // are sent in the order of the requests unless they carry an ID
+    while (true)
+    {
+        // the workers have not accepted the last request yet
+        if (conn->isStalled())
+            break;
+
+        if (!parser.isComplete())
+        {
+            if (input.empty())
+                break;
 
-    // read the Start-of-Transmission character
-    int n = recv(sock, buffer, sizeof(std::uint8_t), 0);
+            // feed the parser with the remaining data
+            input.consume(parser.parse(input.data(), input.size()));
+
+            if (parser.isError()) {
+                std::cerr << "Error: invalid frame received!\n";
+                // purge the connection
+                input.clear();
+                conn->setClosing();
+                break;
+            }
 
-    if (buffer[0] != Constants::Network::Protocol::sot) {
-        std::cerr << "Error: unable to find the SOT marker! [" << std::hex << buffer[0] << "]\n";
-        // purge the socket
-        while(n > 0) {
-            n = recv(sock, buffer, Constants::Network::Protocol::max_read_buffer, 0);
+            // wait for the End-of-Transmission character
+            if (!parser.isComplete())
+                break;
         }
-        return;
-    }
 
-    // wait for the End-of-Transmission character
-    while (true)
-    {
-        // read the next character
-        n = recv(sock, buffer, sizeof(std::uint8_t), 0);
-        if ((buffer[0] == Constants::Network::Protocol::eot) || (n <= 0)) {
+        // a write must not overtake the reads in flight (and vice versa)
+        // the frame stays in the parser until the lane is free and the responses are sent
+        Worker::Pool* pool = selectPool(parser.items());
+        int lane = (pool == pWriter_) ? 1 : 0;
+        if (!conn->canDispatch(lane)) {
+            conn->reactor()->hold(conn);
             break;
         }
 
-        // this is an opcode
-        VM::Opcodes_t op = static_cast<VM::Opcodes_t>(buffer[0]);
+        // take the items decoded by the parser with their memory
+        VM::Arena* arena = parser.releaseArena();
+        Worker::Task* task = arena->create<Worker::Task>();
+        task->arena = arena;
+        std::swap(task->items, parser.items());
+        task->id = parser.releaseID();
+        task->version = parser.version();
+        parser.reset();
+
+        // hand over the command to the workers
+        task->response = new Network::Response(conn, conn->dispatch(lane));
+        task->response->ordered = (task->id == nullptr);
+
+        // the queue is full: the connection is not read anymore until the workers
+        // accept the task (the reactor never executes a command itself)
+        if (!pool->submit(task)) {
+            conn->reactor()->stall(conn, [pool, task]() { return pool->submit(task); });
+            break;
+        }
+    }
+}
 
-        // retrieve the size of the data
-        recv(sock, buffer, sizeof(std::uint16_t), 0);
-        std::uint16_t* p = reinterpret_cast<std::uint16_t*>(buffer);
+// execute a command (from a worker thread) and post the response to the connection
+void KVServer::execute(Worker::Task* task)
+{
+    // interpret the command from the user, the keys listed are streamed
+    if (!task->items.empty() && (task->items.front()->opcode == VM::Opcodes_t::OP_PRT)) {
+        printKeys(task);
+    } else {
+        processCommand(task->items, task->arena);
+    }
 
-        // create a new item
-        VM::QueueItem* item = nullptr;
+    respond(task);
+}
 
-        if (*p == 0) {
-            item = new VM::QueueItem {
-                opcode: op,
-                szdata: 0,
-                pdata: nullptr
-            };
-            items_.push(item);
-        } else {
-            item = new VM::QueueItem {
-                opcode: op,
-                szdata: *p,
-                pdata: new std::uint8_t[(*p) + 1]
-            };
-
-            // read the data
-            memset(item->pdata, 0, (*p) + 1);
-            recv(sock, item->pdata, *p, 0);
-            items_.push(item);
+// execute several writes (from the writer thread) in a single transaction
+// the responses are only posted once the transaction is committed
+void KVServer::executeBatch(Worker::Task** tasks, std::size_t count)
+{
+    pStorage_->begin();
+    pCache_->begin();
+    writes_.clear();
+    for (std::size_t i = 0; i < count; ++i) {
+        processCommand(tasks[i]->items, tasks[i]->arena);
+    }
+    bool committed = pStorage_->commit();
+
+    // the cache never holds uncommitted values, nothing to undo after a rollback
+    if (committed) {
+        for (const CacheWrite& write : writes_) {
+            if (write.erase) {
+                pCache_->erase(write.key.data, write.key.size, write.uid);
+            } else {
+                pCache_->store(write.key.data, write.key.size, write.value.data, write.value.size, write.uid);
+            }
+        }
+    }
+    writes_.clear();
+    pCache_->end();
+
+    for (std::size_t i = 0; i < count; ++i) {
+        // the writes have been lost
+        if (!committed) {
+            createResponse(tasks[i]->items, tasks[i]->arena, VM::Opcodes_t::R_ERROR, std::string("Error: unable to commit the changes!"));
         }
+
+        respond(tasks[i]);
+    }
+}
+
+// build the response of a command executed and post it to the connection
+void KVServer::respond(Worker::Task* task)
+{
+    Network::Response* response = task->response;
+    VM::Arena* arena = task->arena;
+
+    // build the response to the user, in the format of the request
+    if (task->version == Constants::Network::Protocol::version) {
+        sendFrame(response->output, task->items, task->id);
+    } else {
+        sendResponse(response->output, task->items, task->id, !task->streamed);
+    }
+
+    // the output references the memory of the request (the task included)
+    // it will be released once the response has been sent
+    response->output.hold(arena);
+    response->reactor->post(response);
+}
+
+// list the keys of the user matching a pattern, one per line
+// only the range of keys starting with the literal prefix of the pattern is scanned,
+// the keys found are sent in parts as the scan goes, the last part with the response
+void KVServer::printKeys(Worker::Task* task)
+{
+    VM::queue_t& items = task->items;
+    VM::Span pattern{nullptr, 0};
+
+    if (items.size() < 2) {
+        createResponse(items, task->arena, VM::Opcodes_t::R_ERROR, std::string("Error: invalid command!"));
+        return;
     }
 
-    // interpret the command from the user
-    processCommand();
+    // retrieve the UID then the pattern (sent as the key)
+    removeItem(items);
+    int uid = VM::getUID(nextItem(items));
+    removeItem(items);
+    if (!items.empty() && (nextItem(items)->opcode == VM::Opcodes_t::K_NAME)) {
+        pattern = retrieveKey(items, task->arena);
+    }
 
-    // send the response to the user
-    sendResponse(sock);
+    std::shared_ptr<const KVPattern> compiled = pPatterns_->compile(
+        std::string_view(reinterpret_cast<const char*>(pattern.data), pattern.size));
+    if (!compiled) {
+        createResponse(items, task->arena, VM::Opcodes_t::R_ERROR, std::string("Error: invalid regular expression!"));
+        return;
+    }
+
+    // the part being filled
+    std::uint8_t* pData{nullptr};
+    std::size_t size{0};
+    std::size_t capacity{0};
+    bool first{true};
+
+    const std::string& prefix = compiled->prefix();
+    pStorage_->scan(reinterpret_cast<const std::uint8_t*>(prefix.data()), prefix.size(), uid,
+        [&](const std::uint8_t* key, int ksize) {
+            if (!compiled->match(key, ksize))
+                return true;
+
+            std::size_t needed = ksize + (first ? 0 : 1);
+            if ((pData != nullptr) && (size + needed > capacity)) {
+                streamPart(task, pData, size);
+                pData = nullptr;
+            }
 
-    // release the items in the queue
-    freeItems();
+            if (pData == nullptr) {
+                capacity = std::max(Constants::KVServer::scan_chunk_size, needed);
+                pData = new std::uint8_t[capacity];
+                size = 0;
+            }
+
+            if (!first) {
+                pData[size++] = '\n';
+            }
+            memcpy(pData + size, key, ksize);
+            size += ksize;
+            first = false;
+
+            return true;
+        });
+
+    if (pData == nullptr) {
+        createResponse(items, task->arena, VM::Opcodes_t::R_VALUE, std::string());
+        return;
+    }
+
+    task->arena->adopt(pData);
+    createResponse(items, task->arena, VM::Opcodes_t::R_VALUE, pData, static_cast<int>(size));
+}
+
+// post a part of a streamed response (the buffer is released once sent)
+// the parts keep the order of the responses, whatever the request
+void KVServer::streamPart(Worker::Task* task, std::uint8_t* pData, std::size_t size)
+{
+    VM::Arena* arena = VM::Arena::acquire();
+    arena->adopt(pData);
+
+    VM::queue_t items;
+    createResponse(items, arena, VM::Opcodes_t::R_VALUE, pData, static_cast<int>(size));
+
+    Network::Response* part = new Network::Response(task->response);
+    if (task->version == Constants::Network::Protocol::version) {
+        sendFrame(part->output, items, task->id, true);
+    } else {
+        sendResponse(part->output, items, task->id, !task->streamed, false);
+    }
+    part->output.hold(arena);
+
+    task->streamed = true;
+    task->response->ordered = true;
+    part->reactor->post(part);
+}
+
+// the commands modifying the database are executed by the writer
+Worker::Pool* KVServer::selectPool(VM::queue_t& items)
+{
+    if (items.empty())
+        return pReaders_;
+
+    switch(items.front()->opcode)
+    {
+        case VM::Opcodes_t::OP_SET:
+        case VM::Opcodes_t::OP_DEL:
+        case VM::Opcodes_t::OP_EXPDT:
+        case VM::Opcodes_t::OP_EXPDR:
+        case VM::Opcodes_t::OP_MSET:
+        case VM::Opcodes_t::OP_MDEL:
+        case VM::Opcodes_t::OP_INCR:
+        case VM::Opcodes_t::OP_DECR:
+        case VM::Opcodes_t::OP_APPEND:
+        case VM::Opcodes_t::OP_CAS:
+            return pWriter_;
+
+        default:
+            return pReaders_;
+    }
 }
 
 // process the command from the user
-void KVServer::processCommand()
+void KVServer::processCommand(VM::queue_t& items, VM::Arena* arena)
 {
-    std::uint8_t* key{nullptr};
-    std::uint8_t* value{nullptr};
+    VM::Span key{nullptr, 0};
+    VM::Span value{nullptr, 0};
     int uid{0};
-    int ksize{0};
-    int vsize{0};
     DBResult* pResult{nullptr};
 
+    // a command is at least an opcode and a user
+    // an invalid frame should not bring down the whole connection
+    if (items.size() < 2) {
+        createResponse(items, arena, VM::Opcodes_t::R_ERROR, std::string("Error: invalid command!"));
+        return;
+    }
+
     // retrieve the opcode
-    VM::Opcodes_t opcode = nextItem()->opcode;
-    removeItem();
+    VM::Opcodes_t opcode = nextItem(items)->opcode;
+    removeItem(items);
 
     // retrieve the UID
-    uid = VM::getUID(nextItem());
-    removeItem();
+    uid = VM::getUID(nextItem(items));
+    removeItem(items);
 
     // retrieve the KEY
-    if (nextItem()->opcode == VM::Opcodes_t::K_NAME) {
-        key = retrieveKey(&ksize);
+    if (!items.empty() && (nextItem(items)->opcode == VM::Opcodes_t::K_NAME)) {
+        key = retrieveKey(items, arena);
     }
 
     switch(opcode)
     {
         case VM::Opcodes_t::OP_GET:     // retrieve a value from the DB
             {
-                // retrieve the result
-                pResult = pDbase_->fetchRow(key, ksize, uid);
+                // retrieve the result, from the cache first
+                std::uint64_t ticket = pCache_->ticket();
+                pResult = pCache_->fetch(key.data, key.size, uid);
+                if (pResult == nullptr) {
+                    pResult = pStorage_->get(key.data, key.size, uid);
+                    if (pResult != nullptr) {
+                        pCache_->fill(key.data, key.size, pResult->pData, pResult->size, uid, pResult->expiry, ticket);
+                    }
+                }
+
                 if (pResult != nullptr) {
-                    createResponse(VM::Opcodes_t::R_VALUE, pResult);
+                    createResponse(items, arena, VM::Opcodes_t::R_VALUE, pResult);
                 } else {
-                    createResponse(VM::Opcodes_t::R_ERROR, std::string("Error: unable to retrieve data with the key provided!"));
+                    createResponse(items, arena, VM::Opcodes_t::R_ERROR, std::string("Error: unable to retrieve data with the key provided!"));
                 }
             }
             break;
@@ -231,183 +560,608 @@ void KVServer::processCommand()
         case VM::Opcodes_t::OP_SET:     // set a value in the DB
             {
                 // retrieve the value
-                value = retrieveValue(&vsize);
+                value = retrieveValue(items, arena);
 
-                if (pDbase_->insert(key, ksize, value, vsize, uid) == 0) {
-                    createResponse(VM::Opcodes_t::R_ERROR, std::string("Error: unable to insert data with the key provided!"));
+                if (!pStorage_->set(key.data, key.size, value.data, value.size, uid)) {
+                    cacheErase(key, uid);
+                    createResponse(items, arena, VM::Opcodes_t::R_ERROR, std::string("Error: unable to insert data with the key provided!"));
                 } else {
-                    createResponse(VM::Opcodes_t::R_VALUE, std::string("OK"));
+                    // write-through, the next reads don't go to the database
+                    cacheStore(key, value, uid);
+                    createResponse(items, arena, VM::Opcodes_t::R_VALUE, std::string("OK"));
                 }
             }
             break;
 
         case VM::Opcodes_t::OP_EXPDT:   // expiry with a datetime
-            break;
-
         case VM::Opcodes_t::OP_EXPDR:   // expiry with a duration
+            {
+                // seconds since the epoch (0: no expiry) or seconds from now
+                std::int64_t deadline{0};
+                value = retrieveValue(items, arena);
+                bool valid = parseInteger(value, deadline) && (deadline >= 0);
+                if (valid && (opcode == VM::Opcodes_t::OP_EXPDR)) {
+                    std::int64_t now = std::time(nullptr);
+                    valid = (deadline > 0) && (deadline <= std::numeric_limits<std::int64_t>::max() - now);
+                    deadline += now;
+                }
+
+                if (!valid) {
+                    createResponse(items, arena, VM::Opcodes_t::R_ERROR, std::string("Error: invalid expiry!"));
+                    break;
+                }
+
+                // the next read fills the cache with the new expiry
+                cacheErase(key, uid);
+                if (pStorage_->expire(key.data, key.size, uid, deadline)) {
+                    createResponse(items, arena, VM::Opcodes_t::R_VALUE, std::string("OK"));
+                } else {
+                    createResponse(items, arena, VM::Opcodes_t::R_ERROR, std::string("Error: unable to set the expiry of the key!"));
+                }
+            }
             break;
 
         case VM::Opcodes_t::OP_DEL:     // delete a key
             {
-                bool result = pDbase_->remove(key, ksize, uid);
+                cacheErase(key, uid);
+                bool result = pStorage_->remove(key.data, key.size, uid);
                 if (result) {
-                    createResponse(VM::Opcodes_t::V_VALUE, std::string("OK"));
+                    createResponse(items, arena, VM::Opcodes_t::V_VALUE, std::string("OK"));
                 } else {
-                    createResponse(VM::Opcodes_t::R_ERROR, std::string("Error: unable to delete the key!"));
+                    createResponse(items, arena, VM::Opcodes_t::R_ERROR, std::string("Error: unable to delete the key!"));
                 }
             }
             break;
 
-        case VM::Opcodes_t::OP_PRT:     // print key with a regexp
+        case VM::Opcodes_t::OP_PRT:     // print key with a regexp (streamed, see printKeys())
+            break;
+
+        case VM::Opcodes_t::OP_SCAN:    // list the keys in pages
+            {
+                // the size of the page is optional
+                std::int64_t count{Constants::KVServer::scan_page_size};
+                value = retrieveValue(items, arena);
+                if ((value.size > 0) && (!parseInteger(value, count) || (count <= 0))) {
+                    createResponse(items, arena, VM::Opcodes_t::R_ERROR, std::string("Error: invalid count!"));
+                    break;
+                }
+                count = std::min(count, Constants::KVServer::scan_page_max);
+
+                // "0" starts the listing, the next pages start after the cursor returned
+                std::string after;
+                bool first = (key.size == 0) || ((key.size == 1) && (key.data[0] == '0'));
+                if (!first && !decodeCursor(key, after)) {
+                    createResponse(items, arena, VM::Opcodes_t::R_ERROR, std::string("Error: invalid cursor!"));
+                    break;
+                }
+
+                // one more key is read to know if the listing is over
+                std::string page;
+                std::string last;
+                std::int64_t found{0};
+                bool more{false};
+                pStorage_->list(first ? nullptr : reinterpret_cast<const std::uint8_t*>(after.data()), after.size(), uid,
+                    [&](const std::uint8_t* name, int nsize) {
+                        if (found == count) {
+                            more = true;
+                            return false;
+                        }
+
+                        last.assign(reinterpret_cast<const char*>(name), nsize);
+                        page.push_back('\n');
+                        page.append(last);
+                        found++;
+                        return true;
+                    });
+
+                // the cursor comes first, one key per line after it ("0": the listing is over)
+                std::string cursor = more ? encodeCursor(last) : std::string("0");
+                std::size_t size = cursor.size() + page.size();
+                std::uint8_t* pData = static_cast<std::uint8_t*>(arena->allocate(size, 1));
+                memcpy(pData, cursor.data(), cursor.size());
+                memcpy(pData + cursor.size(), page.data(), page.size());
+                createResponse(items, arena, VM::Opcodes_t::R_VALUE, pData, static_cast<int>(size));
+            }
             break;
 
         case VM::Opcodes_t::OP_EXIST:   // check for a key
             {
-                bool result = pDbase_->exists(key, ksize, uid);
+                bool result = pCache_->contains(key.data, key.size, uid) || pStorage_->exists(key.data, key.size, uid);
                 if (result) {
-                    createResponse(VM::Opcodes_t::V_VALUE, "True");
+                    createResponse(items, arena, VM::Opcodes_t::V_VALUE, "True");
                 } else {
-                    createResponse(VM::Opcodes_t::V_VALUE, "False");
+                    createResponse(items, arena, VM::Opcodes_t::V_VALUE, "False");
                 }
             }
             break;
+
+        case VM::Opcodes_t::OP_MGET:    // several keys in a single frame
+        case VM::Opcodes_t::OP_MSET:
+        case VM::Opcodes_t::OP_MDEL:
+            {
+                value = retrieveValue(items, arena);
+                processMulti(opcode, uid, value, items, arena);
+            }
+            break;
+
+        case VM::Opcodes_t::OP_INCR:    // read-modify-write of a key
+        case VM::Opcodes_t::OP_DECR:
+        case VM::Opcodes_t::OP_APPEND:
+        case VM::Opcodes_t::OP_CAS:
+            {
+                value = retrieveValue(items, arena);
+                processUpdate(opcode, uid, key, value, items, arena);
+            }
+            break;
     }
 
-    // free memory
-    delete [] key;
-    delete [] value;
+    // free memory (the key and the value are in the arena)
     delete pResult;
 }
 
+// process a command on several keys, the response has a result per key
+// the reads come from the same state of the storage, the writes are part
+// of the transaction of the writer (committed with the other writes of the batch)
+void KVServer::processMulti(VM::Opcodes_t opcode, int uid, VM::Span payload, VM::queue_t& items, VM::Arena* arena)
+{
+    VM::Span entry{nullptr, 0};
+    std::size_t step = (opcode == VM::Opcodes_t::OP_MSET) ? 2 : 1;
+
+    // count the entries first, the payload is checked before executing anything
+    std::size_t count{0};
+    for (VM::Span remaining = payload; remaining.size > 0; ++count) {
+        if (!VM::readEntry(remaining, entry)) {
+            count = 0;
+            break;
+        }
+    }
+    if ((count == 0) || ((count % step) != 0)) {
+        createResponse(items, arena, VM::Opcodes_t::R_ERROR, std::string("Error: invalid command!"));
+        return;
+    }
+    count /= step;
+
+    // the keys (and the values) reference the payload
+    Storage::Key* keys = static_cast<Storage::Key*>(arena->allocate(count * sizeof(Storage::Key), alignof(Storage::Key)));
+    VM::Span* values = static_cast<VM::Span*>(arena->allocate(count * sizeof(VM::Span), alignof(VM::Span)));
+    for (std::size_t i = 0; i < count; ++i) {
+        VM::readEntry(payload, entry);
+        new (&keys[i]) Storage::Key{Storage::makeKey(entry.data, static_cast<int>(entry.size), uid)};
+        values[i] = VM::Span{nullptr, 0};
+        if (step == 2) {
+            VM::readEntry(payload, values[i]);
+        }
+    }
+
+    freeItems(items);
+
+    switch(opcode)
+    {
+        case VM::Opcodes_t::OP_MGET:
+            {
+                DBResult** results = static_cast<DBResult**>(arena->allocate(count * sizeof(DBResult*), alignof(DBResult*)));
+
+                // the keys missing from the cache are read from the storage at once
+                std::uint64_t ticket = pCache_->ticket();
+                std::size_t missing{0};
+                Storage::Key* misses = static_cast<Storage::Key*>(arena->allocate(count * sizeof(Storage::Key), alignof(Storage::Key)));
+                std::size_t* positions = static_cast<std::size_t*>(arena->allocate(count * sizeof(std::size_t), alignof(std::size_t)));
+                for (std::size_t i = 0; i < count; ++i) {
+                    const Storage::Key& key = keys[i];
+                    results[i] = pCache_->fetch(reinterpret_cast<const std::uint8_t*>(key.key.data()), key.key.size(), uid);
+                    if (results[i] == nullptr) {
+                        new (&misses[missing]) Storage::Key{key};
+                        positions[missing++] = i;
+                    }
+                }
+
+                if (missing > 0) {
+                    DBResult** found = static_cast<DBResult**>(arena->allocate(missing * sizeof(DBResult*), alignof(DBResult*)));
+                    pStorage_->getMany(misses, static_cast<int>(missing), found);
+
+                    for (std::size_t i = 0; i < missing; ++i) {
+                        const Storage::Key& key = misses[i];
+                        if (found[i] != nullptr) {
+                            pCache_->fill(reinterpret_cast<const std::uint8_t*>(key.key.data()), key.key.size(), found[i]->pData,
+                                          found[i]->size, uid, found[i]->expiry, ticket);
+                        }
+                        results[positions[i]] = found[i];
+                    }
+                }
+
+                // the arena takes the buffers of the results, the values are not copied again
+                for (std::size_t i = 0; i < count; ++i) {
+                    DBResult* pResult = results[i];
+                    if (pResult == nullptr) {
+                        appendResult(items, arena, VM::Opcodes_t::R_ERROR, std::string("Error: unable to retrieve data with the key provided!"));
+                        continue;
+                    }
+
+                    std::uint8_t* pData = pResult->pData;
+                    arena->adopt(pData);
+                    pResult->pData = nullptr;
+                    appendResult(items, arena, VM::Opcodes_t::R_VALUE, pData, pResult->size);
+                    delete pResult;
+                }
+            }
+            break;
+
+        case VM::Opcodes_t::OP_MSET:
+            for (std::size_t i = 0; i < count; ++i) {
+                const std::uint8_t* key = reinterpret_cast<const std::uint8_t*>(keys[i].key.data());
+                int ksize = keys[i].key.size();
+
+                if (!pStorage_->set(key, ksize, values[i].data, values[i].size, uid)) {
+                    cacheErase(VM::Span{key, static_cast<std::size_t>(ksize)}, uid);
+                    appendResult(items, arena, VM::Opcodes_t::R_ERROR, std::string("Error: unable to insert data with the key provided!"));
+                } else {
+                    cacheStore(VM::Span{key, static_cast<std::size_t>(ksize)}, values[i], uid);
+                    appendResult(items, arena, VM::Opcodes_t::R_VALUE, std::string("OK"));
+                }
+            }
+            break;
+
+        case VM::Opcodes_t::OP_MDEL:
+            for (std::size_t i = 0; i < count; ++i) {
+                const std::uint8_t* key = reinterpret_cast<const std::uint8_t*>(keys[i].key.data());
+                int ksize = keys[i].key.size();
+
+                cacheErase(VM::Span{key, static_cast<std::size_t>(ksize)}, uid);
+                if (pStorage_->remove(key, ksize, uid)) {
+                    appendResult(items, arena, VM::Opcodes_t::R_VALUE, std::string("OK"));
+                } else {
+                    appendResult(items, arena, VM::Opcodes_t::R_ERROR, std::string("Error: unable to delete the key!"));
+                }
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+// modify the value of a key from its current value (executed by the writer)
+// the writes are serialized: the key can't change between the read and the write,
+// the value read includes the writes of the batch (not committed yet)
+void KVServer::processUpdate(VM::Opcodes_t opcode, int uid, VM::Span key, VM::Span value, VM::queue_t& items, VM::Arena* arena)
+{
+    // the keys written by the batch are not cached until the commit, a hit is the latest value
+    DBResult* pResult = pCache_->fetch(key.data, key.size, uid);
+    if (pResult == nullptr) {
+        pResult = pStorage_->getForUpdate(key.data, key.size, uid);
+    }
+
+    VM::Span current{nullptr, 0};
+    std::int64_t expiry{0};
+    if (pResult != nullptr) {
+        current = VM::Span{pResult->pData, static_cast<std::size_t>(pResult->size)};
+        expiry = pResult->expiry;
+    }
+
+    // the new value and the response
+    VM::Span update{nullptr, 0};
+    std::string reply;
+    std::string error;
+
+    switch(opcode)
+    {
+        case VM::Opcodes_t::OP_INCR:
+        case VM::Opcodes_t::OP_DECR:
+            {
+                std::int64_t delta{0};
+                std::int64_t number{0};
+                if (!parseInteger(value, delta) || ((opcode == VM::Opcodes_t::OP_DECR) && (delta == std::numeric_limits<std::int64_t>::min()))) {
+                    error = "Error: invalid increment!";
+                    break;
+                }
+                if ((pResult != nullptr) && !parseInteger(current, number)) {
+                    error = "Error: the value is not an integer!";
+                    break;
+                }
+
+                if (opcode == VM::Opcodes_t::OP_DECR) {
+                    delta = -delta;
+                }
+                if (((delta > 0) && (number > std::numeric_limits<std::int64_t>::max() - delta)) ||
+                    ((delta < 0) && (number < std::numeric_limits<std::int64_t>::min() - delta))) {
+                    error = "Error: integer overflow!";
+                    break;
+                }
+
+                // the value is cached after the commit, it lives in the arena until then
+                reply = std::to_string(number + delta);
+                std::uint8_t* pData = static_cast<std::uint8_t*>(arena->allocate(reply.size() + 1, 1));
+                memcpy(pData, reply.data(), reply.size() + 1);
+                update = VM::Span{pData, reply.size()};
+            }
+            break;
+
+        case VM::Opcodes_t::OP_APPEND:
+            {
+                std::size_t size = current.size + value.size;
+                std::uint8_t* pData = static_cast<std::uint8_t*>(arena->allocate(size + 1, 1));
+                if (current.size > 0) {
+                    memcpy(pData, current.data, current.size);
+                }
+                if (value.size > 0) {
+                    memcpy(pData + current.size, value.data, value.size);
+                }
+
+                reply = std::to_string(size);
+                update = VM::Span{pData, size};
+            }
+            break;
+
+        case VM::Opcodes_t::OP_CAS:
+            {
+                // the expected value then the new one, or only the new one if the key must not exist
+                VM::Span expected{nullptr, 0};
+                if (!VM::readEntry(value, expected)) {
+                    error = "Error: invalid command!";
+                    break;
+                }
+
+                bool absent = (value.size == 0);
+                if (absent) {
+                    update = expected;
+                } else if (!VM::readEntry(value, update) || (value.size != 0)) {
+                    error = "Error: invalid command!";
+                    break;
+                }
+
+                // an empty value expected only matches an existing key with an empty value
+                if (absent ? (pResult != nullptr) :
+                    ((pResult == nullptr) || (expected.size != current.size) ||
+                     ((current.size > 0) && (memcmp(expected.data, current.data, current.size) != 0)))) {
+                    error = "Error: the value has changed!";
+                    break;
+                }
+
+                reply = "OK";
+            }
+            break;
+
+        default:
+            error = "Error: invalid command!";
+            break;
+    }
+
+    delete pResult;
+    if (!error.empty()) {
+        createResponse(items, arena, VM::Opcodes_t::R_ERROR, error);
+        return;
+    }
+
+    if (!pStorage_->set(key.data, key.size, update.data, update.size, uid)) {
+        cacheErase(key, uid);
+        createResponse(items, arena, VM::Opcodes_t::R_ERROR, std::string("Error: unable to insert data with the key provided!"));
+        return;
+    }
+
+    // the key keeps its expiry (a set clears it), the next read fills the cache
+    if (expiry != 0) {
+        cacheErase(key, uid);
+        pStorage_->expire(key.data, key.size, uid, expiry);
+    } else {
+        cacheStore(key, update, uid);
+    }
+
+    createResponse(items, arena, VM::Opcodes_t::R_VALUE, reply);
+}
+
+// parse an integer in ASCII (expiry, count...)
+bool KVServer::parseInteger(VM::Span value, std::int64_t& result)
+{
+    if ((value.data == nullptr) || (value.size == 0))
+        return false;
+
+    const char* first = reinterpret_cast<const char*>(value.data);
+    const char* last = first + value.size;
+    auto [ptr, error] = std::from_chars(first, last, result);
+    return (error == std::errc{}) && (ptr == last);
+}
+
+// a value written by the batch, the readers go to the database until the commit
+void KVServer::cacheStore(VM::Span key, VM::Span value, int uid)
+{
+    pCache_->erase(key.data, key.size, uid);
+    writes_.push_back(CacheWrite{key: key, value: value, uid: uid, erase: false});
+}
+
+// a key removed (or rewritten without its value), only undoes a previous store of the batch
+void KVServer::cacheErase(VM::Span key, int uid)
+{
+    pCache_->erase(key.data, key.size, uid);
+    if (!writes_.empty()) {
+        writes_.push_back(CacheWrite{key: key, value: VM::Span{nullptr, 0}, uid: uid, erase: true});
+    }
+}
+
 // send the response to the user
-void KVServer::sendResponse(int sock)
+// the frame is gathered in the output list and sent with a single write
+void KVServer::sendResponse(Network::Output& output, VM::queue_t& items, VM::QueueItem* id, bool first, bool last)
 {
     // send start of transmission
-    send(sock, &Constants::Network::Protocol::sot, 1, 0);
+    if (first) {
+        output.append(&Constants::Network::Protocol::sot, 1);
+    }
+
+    // send back the request ID first
+    if (first && (id != nullptr)) {
+        std::uint8_t value = static_cast<std::uint8_t>(id->opcode);
+        std::uint16_t size = static_cast<std::uint16_t>(id->szdata);
+        output.append(&value, sizeof(value));
+        output.append(&size, sizeof(size));
+        output.append(id->pdata, id->szdata);
+    }
 
     // send all the blocks
-    while (!items_.empty())
+    while (!items.empty())
     {
         std::uint8_t value{};
 
         // retrieve the item
-        auto* item = items_.front();
+        auto* item = items.front();
 
         // send the opcode
         value = static_cast<std::uint8_t>(item->opcode);
-        send(sock, &value, sizeof(value), 0);
+        output.append(&value, sizeof(value));
 
-        // retrieve the size + value
-        if (item->szdata == 0) {
-            std::uint16_t zero = 0;
-            send(sock, reinterpret_cast<std::uint8_t*>(&zero), sizeof(zero), 0);
-        } else {
-            send(sock, reinterpret_cast<std::uint8_t*>(&item->szdata), sizeof(item->szdata), 0);
-            send(sock, item->pdata, item->szdata, 0);
-        }
+        // send the size + value (the data stays in the arena until sent)
+        // the blocks of a response never exceed max_item_size
+        std::uint16_t size = static_cast<std::uint16_t>(item->szdata);
+        output.append(&size, sizeof(size));
+        output.reference(item->pdata, item->szdata);
 
         // next item
-        items_.pop();
-        delete item;
+        items.pop();
     }
 
     // send end of transmission
-    send(sock, &Constants::Network::Protocol::eot, 1, 0);
+    if (last) {
+        output.append(&Constants::Network::Protocol::eot, 1);
+    }
 }
 
-// retrieve the data from an item block
-std::uint8_t* KVServer::retrieveData(int* size, VM::Opcodes_t opcode)
+// send the response to the user in a v2 frame
+// the header carries the result code of the first block and the size of all of them
+void KVServer::sendFrame(Network::Output& output, VM::queue_t& items, VM::QueueItem* id, bool more)
 {
-    std::uint8_t* value = nullptr;
-    std::uint16_t total_size{0};
+    VM::FrameHeader header{};
+    header.magic = Constants::Network::Protocol::magic;
+    header.version = Constants::Network::Protocol::version;
+    header.opcode = static_cast<std::uint8_t>(VM::Opcodes_t::R_ERROR);
+
+    // a part of a streamed response
+    if (more) {
+        header.flags |= VM::F_MORE;
+    }
 
-    while(!items_.empty())
-    {
-        // retrieve the next element from the queue (but don't remove it yet)
-        auto* item = items_.front();
+    // send back the request ID
+    if ((id != nullptr) && (id->szdata == sizeof(header.id))) {
+        header.flags |= VM::F_ID;
+        memcpy(&header.id, id->pdata, sizeof(header.id));
+    }
 
-        // no longer a K_NAME element
-        if (item->opcode != opcode)
-            break;
+    // the blocks are sent after the header
+    if (!items.empty()) {
+        header.opcode = static_cast<std::uint8_t>(items.front()->opcode);
+    }
+    for (auto* item = items.front(); item != nullptr; item = item->next) {
+        header.value_length += item->szdata;
+    }
+    header.total_length = header.value_length;
 
-        // retrieve the data from the block
-        std::uint16_t size{0};
-        std::uint8_t* data = VM::getData(item, &size);
+    output.append(&header, sizeof(header));
 
-        // initial block
-        if (value == nullptr) {
-            value = data;
-            total_size = size;
-        } else {
-            // we need to move the data elsewhere ...
-            int new_size = total_size + size + 1;
-            std::uint8_t* new_ptr = new std::uint8_t[new_size];
+    // the data stays in the arena until sent
+    while (!items.empty())
+    {
+        auto* item = items.front();
+        output.reference(item->pdata, item->szdata);
+        items.pop();
+    }
+}
 
-            // copy the data
-            memset(new_ptr, 0, new_size);
-            memcpy(new_ptr, value, total_size);
-            memcpy(new_ptr + total_size, data, size);
+// retrieve the data from consecutive item blocks with the same opcode
+// a single block (v2 frame) is used in place, several blocks (v1 frame)
+// are gathered with a single copy in the arena
+VM::Span KVServer::retrieveData(VM::queue_t& items, VM::Arena* arena, VM::Opcodes_t opcode)
+{
+    VM::Span span{nullptr, 0};
 
-            // compute the new size
-            total_size = total_size + size;
+    // count the blocks and their total size
+    int count{0};
+    for (auto* item = items.front(); (item != nullptr) && (item->opcode == opcode); item = item->next) {
+        if (count == 0) {
+            span.data = item->pdata;
+        }
+        span.size += item->szdata;
+        count++;
+    }
 
-            // delete previous buffer
-            delete [] value;
-            delete [] data;
+    // gather the data of all the blocks
+    if (count > 1) {
+        std::uint8_t* pData = static_cast<std::uint8_t*>(arena->allocate(span.size + 1, 1));
+        std::size_t offset{0};
 
-            // this is the new value
-            value = new_ptr;
+        for (auto* item = items.front(); offset < span.size; item = item->next) {
+            memcpy(pData + offset, item->pdata, item->szdata);
+            offset += item->szdata;
         }
+        pData[span.size] = 0;
 
-        // remove the element from the queue
-        items_.pop();
-        delete item;
+        span.data = pData;
     }
 
-    *size = total_size;
-    return value;
+    // remove the elements from the queue
+    for (int i = 0; i < count; ++i) {
+        removeItem(items);
+    }
+
+    return span;
 }
 
 // retrieve the Key from the queue by aggregating multiple K_NAME blocks
-std::uint8_t* KVServer::retrieveKey(int* size)
+VM::Span KVServer::retrieveKey(VM::queue_t& items, VM::Arena* arena)
 {
-    return retrieveData(size, VM::Opcodes_t::K_NAME);
+    return retrieveData(items, arena, VM::Opcodes_t::K_NAME);
 }
 
 // retrieve the Value from the queue by aggregating multiple V_VALUE blocks
-std::uint8_t* KVServer::retrieveValue(int* size)
+VM::Span KVServer::retrieveValue(VM::queue_t& items, VM::Arena* arena)
 {
-    return retrieveData(size, VM::Opcodes_t::V_VALUE);
+    return retrieveData(items, arena, VM::Opcodes_t::V_VALUE);
 }
 
 
 // create a response from a std::uint8_t pointer
-// TO BE DONE
-void KVServer::createResponse(VM::Opcodes_t code, std::uint8_t* pData, int size)
+// the data must be owned by the arena, the blocks reference them
+void KVServer::createResponse(VM::queue_t& items, VM::Arena* arena, VM::Opcodes_t code, std::uint8_t* pData, int size)
 {
     // delete the remaining item in the queue
     // at this point they are not needed anymore
-    freeItems();
+    freeItems(items);
+
+    appendBlocks(items, arena, code, pData, size);
 }
 
 // create a response from a DB result
-// TODO:
-// DBResult has already allocated memory for the result
-// we can use this and avoid re-allocated a second time the memory
-// just to release it again later on
-void KVServer::createResponse(VM::Opcodes_t code, DBResult* pResult)
+// the arena takes the buffer of the result, the blocks reference it and
+// the output sends it in place: the value is never copied again
+void KVServer::createResponse(VM::queue_t& items, VM::Arena* arena, VM::Opcodes_t code, DBResult* pResult)
+{
+    std::uint8_t* pData = pResult->pData;
+    arena->adopt(pData);
+    pResult->pData = nullptr;
+
+    createResponse(items, arena, code, pData, pResult->size);
+}
+
+// create a response with a simple string message
+void KVServer::createResponse(VM::queue_t& items, VM::Arena* arena, VM::Opcodes_t code, std::string msg)
 {
     // delete the remaining item in the queue
     // at this point they are not needed anymore
-    freeItems();
+    freeItems(items);
+
+    // create the new item with a copy of the message
+    VM::QueueItem* item = VM::createItem(arena, code, msg.data(), std::size(msg));
 
+    // add the item to the queue
+    items.push(item);
+}
+
+// add the blocks of a response (of regular size) to the queue
+void KVServer::appendBlocks(VM::queue_t& items, VM::Arena* arena, VM::Opcodes_t code, std::uint8_t* pData, int size)
+{
     // only create block of regular size
-    int item_size = pResult->size;
+    // (an empty value still gets a block: it carries the result code)
     int count = 0;
 
-    while (count < item_size)
+    do
     {
-        int remaining = item_size - count;
+        int remaining = size - count;
 
         int block_size = 0;
         if (remaining > Constants::Network::Protocol::max_item_size) {
@@ -417,37 +1171,34 @@ void KVServer::createResponse(VM::Opcodes_t code, DBResult* pResult)
         }
 
         // create a new block
-        VM::QueueItem* item = new VM::QueueItem {
-            opcode: code,
-            szdata: static_cast<std::uint16_t>(block_size),
-            pdata: new std::uint8_t[block_size]
-        };
-
-        // copy the data to the block (to find a clever way to do it)
-        memcpy(item->pdata, pResult->pData+count, block_size);
+        VM::QueueItem* item = arena->create<VM::QueueItem>();
+        item->opcode = code;
+        item->szdata = block_size;
+        item->pdata = pData + count;
         count += block_size;
 
-        items_.push(item);
-    }
+        items.push(item);
+    } while (count < size);
 }
 
-// create a response with a simple string message
-void KVServer::createResponse(VM::Opcodes_t code, std::string msg)
+// add the result of a key to the response of a command on several keys
+// the result code and the size come first, in a block of their own
+void KVServer::appendResult(VM::queue_t& items, VM::Arena* arena, VM::Opcodes_t code, std::uint8_t* pData, int size)
 {
-    // delete the remaining item in the queue
-    // at this point they are not needed anymore
-    freeItems();
+    std::uint32_t length = static_cast<std::uint32_t>(size);
+    VM::QueueItem* header = VM::createItem(arena, VM::Opcodes_t::R_VALUE, sizeof(std::uint8_t) + sizeof(length));
+    header->pdata[0] = static_cast<std::uint8_t>(code);
+    memcpy(header->pdata + sizeof(std::uint8_t), &length, sizeof(length));
+    items.push(header);
 
-    // create the new item
-    VM::QueueItem* item = new VM::QueueItem {
-        opcode: code,
-        szdata: std::size(msg),
-        pdata: new std::uint8_t[std::size(msg)]
-    };
+    appendBlocks(items, arena, VM::Opcodes_t::R_VALUE, pData, size);
+}
 
-    // copy the message
-    memcpy(item->pdata, msg.data(), std::size(msg));
+// add the result of a key with a simple string message
+void KVServer::appendResult(VM::queue_t& items, VM::Arena* arena, VM::Opcodes_t code, std::string msg)
+{
+    std::uint8_t* pData = static_cast<std::uint8_t*>(arena->allocate(msg.size(), 1));
+    memcpy(pData, msg.data(), msg.size());
 
-    // add the item to the queue
-    items_.push(item);
-}
\ No newline at end of file
+    appendResult(items, arena, code, pData, static_cast<int>(msg.size()));
+}
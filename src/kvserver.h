@@ -8,24 +8,33 @@
 #define KVSERVER_H
 
 // ----- includes
+#include "kvcache.h"
 #include "kvdbase.h"
+#include "kvpattern.h"
 #include "network.h"
+#include "storage.h"
 #include "vm/defines.h"
+#include "worker.h"
 
+#include <atomic>
 #include <string>
+#include <vector>
 
 
 // ----- class
 class KVServer
 {
 public:     //< public methods
-    KVServer(std::string address, std::string port, std::string dbname);
+    KVServer(std::string address, std::string port, std::string socket, int threads, std::string backend, int workers,
+             std::string engine, std::string dbname, DBSettings settings, CacheSettings cache);
     ~KVServer();
 
     void start();
     void stop();
 
-    void callback(int sock);
+    void callback(Network::Connection* conn);
+    void execute(Worker::Task* task);
+    void executeBatch(Worker::Task** tasks, std::size_t count);     //< group commit of the writes
     void signalHandler(int signal);
 
     // no copy
@@ -37,29 +46,66 @@ public:     //< public methods
     KVServer& operator=(KVServer&&) = delete;
 
 private:    //< private methods
-    void processCommand();
-    void sendResponse(int sock);
-
-    void createResponse(VM::Opcodes_t code, std::uint8_t* pData, int size);
-    void createResponse(VM::Opcodes_t code, DBResult* pResult);
-    void createResponse(VM::Opcodes_t code, std::string msg);
+    // the queue of items is owned by the caller as requests are processed concurrently
+    // the items, the key, the value and the response are allocated in the arena of the request
+    void processCommand(VM::queue_t& items, VM::Arena* arena);
+    void processMulti(VM::Opcodes_t opcode, int uid, VM::Span payload, VM::queue_t& items, VM::Arena* arena);
+    void processUpdate(VM::Opcodes_t opcode, int uid, VM::Span key, VM::Span value, VM::queue_t& items, VM::Arena* arena);
+    void respond(Worker::Task* task);               //< send the response of an executed task
+    void printKeys(Worker::Task* task);             //< OP_PRT, the keys are streamed
+    void streamPart(Worker::Task* task, std::uint8_t* pData, std::size_t size);   //< post a part of the response
+
+    // a v1 response sent in parts: the first one starts the frame, the last one ends it
+    void sendResponse(Network::Output& output, VM::queue_t& items, VM::QueueItem* id, bool first = true, bool last = true);
+    void sendFrame(Network::Output& output, VM::queue_t& items, VM::QueueItem* id, bool more = false);    //< v2 frame
+    Worker::Pool* selectPool(VM::queue_t& items);   //< readers or writer, depending on the command
+    Storage::Engine* createEngine(std::string engine, std::string dbname, int readers, DBSettings settings);
+    void purgeExpired();                            //< delete the expired keys (from the mainloop)
+    bool parseInteger(VM::Span value, std::int64_t& result);    //< ASCII integer
+
+    // the writes of a batch only reach the cache once committed, the key is erased meanwhile
+    void cacheStore(VM::Span key, VM::Span value, int uid);
+    void cacheErase(VM::Span key, int uid);
+
+    void createResponse(VM::queue_t& items, VM::Arena* arena, VM::Opcodes_t code, std::uint8_t* pData, int size);
+    void createResponse(VM::queue_t& items, VM::Arena* arena, VM::Opcodes_t code, DBResult* pResult);
+    void createResponse(VM::queue_t& items, VM::Arena* arena, VM::Opcodes_t code, std::string msg);
+
+    // the blocks of a response are added to the queue, the data must be owned by the arena
+    void appendBlocks(VM::queue_t& items, VM::Arena* arena, VM::Opcodes_t code, std::uint8_t* pData, int size);
+    void appendResult(VM::queue_t& items, VM::Arena* arena, VM::Opcodes_t code, std::uint8_t* pData, int size);
+    void appendResult(VM::queue_t& items, VM::Arena* arena, VM::Opcodes_t code, std::string msg);
 
     // queue management
-    void freeItems();               //< remove all the items from the queue
-    VM::QueueItem* nextItem();      //< return the value in front of the queue (but don't remove it)
-    void removeItem();              //< remove the value in front of the queue
+    void freeItems(VM::queue_t& items);             //< remove all the items from the queue
+    VM::QueueItem* nextItem(VM::queue_t& items);    //< return the value in front of the queue (but don't remove it)
+    void removeItem(VM::queue_t& items);            //< remove the value in front of the queue
 
 
-    std::uint8_t* retrieveData(int* size, VM::Opcodes_t opcode);
-    std::uint8_t* retrieveKey(int* size);
-    std::uint8_t* retrieveValue(int* size);
+    // the data are used in place when they come in a single block
+    VM::Span retrieveData(VM::queue_t& items, VM::Arena* arena, VM::Opcodes_t opcode);
+    VM::Span retrieveKey(VM::queue_t& items, VM::Arena* arena);
+    VM::Span retrieveValue(VM::queue_t& items, VM::Arena* arena);
 
 
 private:    //< private members
-    KVDbase* pDbase_;
+    Storage::Engine* pStorage_;     //< SQLite or memory
+    KVCache* pCache_;               //< hot values served without the database
+    KVPatterns* pPatterns_;         //< compiled patterns of the scans
     Network::TCPServer* pServer_;
-    bool done_;
-    VM::queue_t items_;
+    Worker::Pool* pReaders_;        //< concurrent read-only commands
+    Worker::Pool* pWriter_;         //< a single thread serializes the writes
+    std::atomic<bool> done_;
+
+    // a write of the batch in progress (writer thread), the data are in the arena of its task
+    struct CacheWrite
+    {
+        VM::Span key;
+        VM::Span value;
+        int uid;
+        bool erase;
+    };
+    std::vector<CacheWrite> writes_;    //< applied to the cache after the commit
 };
 
 
@@ -22,21 +22,45 @@ int main(int argc, char* argv[])
 
     // start the TCP Server
     if (app.config().is_server) {
-        KVServer kvserver(app.config().srv_address, app.config().srv_port, app.config().database);
+        DBSettings settings{
+            journal_mode: app.config().db_journal_mode,
+            synchronous: app.config().db_synchronous,
+            mmap_size: app.config().db_mmap_size,
+            cache_size: app.config().db_cache_size,
+            page_size: app.config().db_page_size,
+            busy_timeout: app.config().db_busy_timeout,
+            temp_store: app.config().db_temp_store
+        };
+
+        CacheSettings cache{
+            memory: app.config().cache_memory,
+            policy: app.config().cache_policy
+        };
+
+        KVServer kvserver(app.config().srv_address, app.config().srv_port, app.config().srv_socket,
+                          app.config().srv_threads, app.config().srv_backend, app.config().srv_workers,
+                          app.config().db_engine, app.config().database, settings, cache);
         kvserver.start();
     } else {
         // create a new client instance
-        KVClient kvclient(app.config().clt_address, app.config().clt_port);
+        KVClient kvclient(app.config().clt_address, app.config().clt_port, app.config().clt_socket);
         kvclient.setUser(app.config().uid, app.config().gid);
 
+        // execute all the commands from STDIN on the same connection
+        auto& args = app.cmdline().args();
+        if ((args.size() > 0) && (args[0].compare("batch") == 0)) {
+            retval = kvclient.batch();
+        }
         // parse the command line
-        kvclient.parse(app.cmdline());
-
-        // send the data to the server
-        kvclient.send();
+        else if (kvclient.parse(app.cmdline())) {
+            // send the data to the server
+            kvclient.send();
 
-        // read the server's response
-        retval = kvclient.recv();
+            // read the server's response
+            retval = kvclient.recv();
+        } else {
+            retval = EXIT_FAILURE;
+        }
     }
 
     return retval;
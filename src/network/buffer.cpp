@@ -0,0 +1,130 @@
+/*
+ * @file    buffer.cpp
+ * @brief   Source file for Network Buffer class
+ */
+
+// ----- includes
+#include "../constants.h"
+#include "buffer.h"
+
+#include <string.h>
+
+#include <utility>
+
+
+namespace Network
+{
+
+// ----- class
+
+// constructor
+Buffer::Buffer() :
+    pData_{nullptr}, capacity_{static_cast<std::size_t>(Constants::Network::Protocol::max_read_buffer)}, head_{0}, tail_{0}
+{
+    pData_ = new std::uint8_t[capacity_];
+}
+
+// destructor
+Buffer::~Buffer()
+{
+    delete [] pData_;
+    pData_ = nullptr;
+}
+
+// return the first byte not yet consumed
+std::uint8_t* Buffer::data()
+{
+    return pData_ + head_;
+}
+
+// return the number of bytes not yet consumed
+std::size_t Buffer::size() const
+{
+    return tail_ - head_;
+}
+
+// the buffer does not contain any data
+bool Buffer::empty() const
+{
+    return head_ == tail_;
+}
+
+// remove n bytes from the head of the buffer
+void Buffer::consume(std::size_t n)
+{
+    head_ += n;
+    if (head_ < tail_)
+        return;
+
+    // rewind the buffer once everything has been consumed
+    clear();
+}
+
+// remove all the data from the buffer
+void Buffer::clear()
+{
+    head_ = 0;
+    tail_ = 0;
+
+    // give back the memory used by a large value
+    if (capacity_ > Constants::Network::Protocol::max_buffer_keep) {
+        delete [] pData_;
+        capacity_ = Constants::Network::Protocol::max_read_buffer;
+        pData_ = new std::uint8_t[capacity_];
+    }
+}
+
+// append some data at the tail of the buffer
+void Buffer::append(const void* pData, std::size_t n)
+{
+    memcpy(reserve(n), pData, n);
+    commit(n);
+}
+
+// ensure there is room for n bytes at the tail of the buffer
+std::uint8_t* Buffer::reserve(std::size_t n)
+{
+    if (tail_ + n <= capacity_)
+        return pData_ + tail_;
+
+    // move the remaining data at the beginning of the buffer
+    std::size_t size = tail_ - head_;
+    if (size + n <= capacity_) {
+        memmove(pData_, pData_ + head_, size);
+    } else {
+        // grow the buffer
+        std::size_t capacity = capacity_;
+        while (capacity < size + n) {
+            capacity *= 2;
+        }
+
+        std::uint8_t* pData = new std::uint8_t[capacity];
+        memcpy(pData, pData_ + head_, size);
+        delete [] pData_;
+
+        pData_ = pData;
+        capacity_ = capacity;
+    }
+
+    head_ = 0;
+    tail_ = size;
+
+    return pData_ + tail_;
+}
+
+// validate the n bytes written after a call to reserve()
+void Buffer::commit(std::size_t n)
+{
+    tail_ += n;
+}
+
+// exchange the content of two buffers
+void Buffer::swap(Buffer& other)
+{
+    std::swap(pData_, other.pData_);
+    std::swap(capacity_, other.capacity_);
+    std::swap(head_, other.head_);
+    std::swap(tail_, other.tail_);
+}
+
+}   //< end namespace
@@ -0,0 +1,56 @@
+/*
+ * @file    buffer.h
+ * @brief   Header file for Network Buffer class
+ */
+
+// ----- guards
+#ifndef NETWORK_BUFFER_H
+#define NETWORK_BUFFER_H
+
+// ----- includes
+#include <cstddef>
+#include <cstdint>
+
+
+// ----- class
+namespace Network
+{
+    // growable byte buffer with a read and a write position
+    // data are appended at the tail and consumed from the head
+    class Buffer
+    {
+    public:     //< public methods
+        Buffer();
+        ~Buffer();
+
+        // no copy semantics
+        Buffer(const Buffer&) = delete;
+        Buffer& operator=(const Buffer&) = delete;
+
+        // no move semantics
+        Buffer(Buffer&&) = delete;
+        Buffer& operator=(Buffer&&) = delete;
+
+        std::uint8_t* data();                   //< first byte not yet consumed
+        std::size_t size() const;               //< number of bytes not yet consumed
+        bool empty() const;
+
+        void consume(std::size_t n);            //< remove n bytes from the head
+        void clear();
+
+        void append(const void* pData, std::size_t n);
+        std::uint8_t* reserve(std::size_t n);   //< return room for n bytes at the tail
+        void commit(std::size_t n);             //< validate n bytes written in the reserved room
+
+        void swap(Buffer& other);               //< exchange the content of two buffers
+
+    private:    //< private members
+        std::uint8_t* pData_;                   //< the memory block
+        std::size_t capacity_;                  //< size of the memory block
+        std::size_t head_;                      //< read position
+        std::size_t tail_;                      //< write position
+    };
+
+}
+
+#endif // NETWORK_BUFFER_H
@@ -4,13 +4,18 @@
  */
 
 // ----- includes
+#include "../constants.h"
 #include "client.h"
 
 #include <arpa/inet.h>
+#include <errno.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <sys/epoll.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/un.h>
+#include <string.h>
 #include <unistd.h>
 
 #include <iostream>
@@ -21,7 +26,7 @@ namespace Network
 
 // ----- methods
 TCPClient::TCPClient(std::string address, std::string port) :
-    Interface{address, port}
+    Interface{address, port}, path_{}, connected_{false}, input_{}
 {
     // create the socket
     socket_ = socket(AF_INET, SOCK_STREAM, 0);
@@ -31,6 +36,17 @@ TCPClient::TCPClient(std::string address, std::string port) :
     }
 }
 
+TCPClient::TCPClient(std::string path) :
+    Interface{path, ""}, path_{path}, connected_{false}, input_{}
+{
+    // create the socket
+    socket_ = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (socket_ < 0) {
+        std::cerr << "Error: unable to create the client socket!\n";
+        std::exit(EXIT_FAILURE);
+    }
+}
+
 /*virtual*/ TCPClient::~TCPClient()
 {
     if (socket_ > 0) {
@@ -39,9 +55,19 @@ TCPClient::TCPClient(std::string address, std::string port) :
     }
 }
 
-// connect to the server
+// connect to the server (once)
 void TCPClient::connect()
 {
+    // reuse the current connection
+    if (connected_)
+        return;
+
+    // same host: skip the TCP/IP stack
+    if (path_.size() != 0) {
+        connectLocal();
+        return;
+    }
+
     // connection structure
     sockaddr_in s;
     s.sin_family = AF_INET;
@@ -68,23 +94,78 @@ void TCPClient::connect()
         std::cerr << "Error: unable to connect to server [" << address_ << ":" << port_ << "]\n";
         std::exit(EXIT_FAILURE);
     }
+
+    // the connection is kept open: don't let Nagle delay the small frames
+    int nodelay = 1;
+    setsockopt(socket_, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+
+    connected_ = true;
 }
 
-// send data to the server
-void TCPClient::send(std::uint8_t *pData, int size)
+// connect to the server through its UNIX domain socket
+void TCPClient::connectLocal()
 {
-    int res = ::send(socket_, pData, size, 0);
-    if (res != size) {
-        std::cerr << "Error: only " << res << " bytes sent out of " << size << "\n";
+    sockaddr_un s;
+    memset(&s, 0, sizeof(s));
+    s.sun_family = AF_UNIX;
+
+    if (path_.size() >= sizeof(s.sun_path)) {
+        std::cerr << "Error: the socket path is too long [" << path_ << "]\n";
+        std::exit(EXIT_FAILURE);
+    }
+    strncpy(s.sun_path, path_.c_str(), sizeof(s.sun_path) - 1);
+
+    // connect to the server
+    if (::connect(socket_, (struct sockaddr*)&s, sizeof(s)) < 0) {
+        std::cerr << "Error: unable to connect to server [" << path_ << "]\n";
         std::exit(EXIT_FAILURE);
     }
+
+    connected_ = true;
+}
+
+// the client is connected to the server
+bool TCPClient::isConnected() const
+{
+    return connected_;
+}
+
+// send data to the server
+void TCPClient::send(Output& output)
+{
+    // the socket is blocking: loop only on partial writes
+    while (!output.empty())
+    {
+        if (output.write(socket_) < 0) {
+            std::cerr << "Error: unable to send data to the server!\n";
+            std::exit(EXIT_FAILURE);
+        }
+    }
+}
+
+// read the data available from the server into the input buffer
+// return the number of bytes read, 0 if the server closed the connection
+int TCPClient::recv()
+{
+    int size = Constants::Network::Protocol::max_read_buffer;
+
+    while (true)
+    {
+        int res = ::recv(socket_, input_.reserve(size), size, 0);
+        if ((res < 0) && (errno == EINTR))
+            continue;
+
+        if (res > 0)
+            input_.commit(res);
+
+        return res;
+    }
 }
 
-// recv data from the server
-int TCPClient::recv(std::uint8_t *pData, int n)
+// return the read buffer
+Buffer& TCPClient::input()
 {
-    int res = ::recv(socket_, pData, n, 0);
-    return res;
+    return input_;
 }
 
 } //< end namespace
\ No newline at end of file
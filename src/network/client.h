@@ -8,7 +8,9 @@
 #define NETWORK_CLIENT_H
 
 // ----- includes
+#include "buffer.h"
 #include "interface.h"
+#include "output.h"
 
 #include <cstdint>
 
@@ -19,11 +21,15 @@ namespace Network
     {
     public:
         TCPClient(std::string address, std::string port);
+        TCPClient(std::string path);    //< UNIX domain socket
         virtual ~TCPClient();
 
         void connect();
-        void send(std::uint8_t*, int n);
-        int recv(std::uint8_t*, int n);
+        bool isConnected() const;
+        void send(Output& output);      //< send the whole output list
+        int recv();                     //< read the available data into the input buffer
+
+        Buffer& input();                //< data received but not yet consumed
 
 
         // no copy semantics
@@ -34,7 +40,13 @@ namespace Network
         TCPClient(TCPClient&&) = delete;
         TCPClient& operator=(TCPClient&&) = delete;
 
+    private:    //< private methods
+        void connectLocal();
 
+    private:    //< private members
+        std::string path_;              //< UNIX socket path (empty for TCP)
+        bool connected_;                //< the connection is kept open for several commands
+        Buffer input_;                  //< read buffer
     };
 
 } //< end namespace
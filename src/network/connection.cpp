@@ -0,0 +1,314 @@
+/*
+ * @file    connection.cpp
+ * @brief   Source file for Network Connection class
+ */
+
+// ----- includes
+#include "../constants.h"
+#include "connection.h"
+#include "response.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+
+
+namespace Network
+{
+
+// ----- functions
+namespace
+{
+    std::atomic<std::uint64_t> next_id{1};
+}
+
+
+// ----- class
+
+// constructor
+Connection::Connection(int sock, Reactor* reactor) :
+    socket_{sock}, id_{next_id++}, reactor_{reactor}, closing_{false}, stalled_{false}, held_{false},
+    inflight_{0}, lane_{0}, next_seq_{0}, next_send_{0}, streaming_{false}, reorder_{},
+    last_activity_{std::chrono::steady_clock::now()}, input_{}, output_{}, parser_{}
+{ }
+
+// destructor
+/*virtual*/ Connection::~Connection()
+{
+    for (auto& it : reorder_) {
+        delete it.second;
+    }
+    reorder_.clear();
+
+    if (socket_ > 0) {
+        close(socket_);
+        socket_ = -1;
+    }
+}
+
+// return the client socket
+int Connection::socket() const
+{
+    return socket_;
+}
+
+// return the connection ID
+std::uint64_t Connection::id() const
+{
+    return id_;
+}
+
+// return the reactor serving the connection
+Reactor* Connection::reactor() const
+{
+    return reactor_;
+}
+
+// read all the available data from the socket
+// return the number of bytes read, or -1 if the connection is closed / in error
+int Connection::read()
+{
+    int total{0};
+
+    while (true)
+    {
+        // a large block is received in its own memory, without any copy
+        std::size_t room{0};
+        std::uint8_t* pBlock = input_.empty() ? parser_.pending(&room) : nullptr;
+        bool direct = (pBlock != nullptr) && (room >= Constants::Network::min_direct_read);
+
+        // otherwise read directly at the end of the buffer
+        int size = direct ? static_cast<int>(room) : Constants::Network::Protocol::max_read_buffer;
+        int n = ::recv(socket_, direct ? pBlock : input_.reserve(size), size, 0);
+
+        if (n > 0) {
+            if (direct) {
+                parser_.commit(n);
+            } else {
+                input_.commit(n);
+            }
+            touch();
+            total += n;
+
+            // a short read means the socket has been drained
+            if (n < size)
+                return total;
+            continue;
+        }
+
+        // connection closed by the peer
+        if (n == 0)
+            return -1;
+
+        if (errno == EINTR)
+            continue;
+
+        // nothing more to read for now
+        if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+            return total;
+
+        return -1;
+    }
+}
+
+// add some data received by the reactor
+// the block being read is filled directly rather than through the buffer
+void Connection::receive(const std::uint8_t* pData, std::size_t n)
+{
+    if (input_.empty()) {
+        std::size_t room{0};
+        std::uint8_t* pBlock = parser_.pending(&room);
+        if (pBlock != nullptr) {
+            std::size_t count = std::min(n, room);
+            memcpy(pBlock, pData, count);
+            parser_.commit(count);
+
+            pData += count;
+            n -= count;
+        }
+    }
+
+    input_.append(pData, n);
+}
+
+// write as much pending data as possible to the socket
+// return the number of bytes written, or -1 if the connection is in error
+int Connection::write()
+{
+    int n = output_.write(socket_);
+    if (n > 0) {
+        touch();
+    }
+
+    return n;
+}
+
+// return the read buffer
+Buffer& Connection::input()
+{
+    return input_;
+}
+
+// return the write buffer
+Output& Connection::output()
+{
+    return output_;
+}
+
+// return the parser for this connection
+VM::Parser& Connection::parser()
+{
+    return parser_;
+}
+
+// some data are waiting to be sent
+bool Connection::isPending() const
+{
+    return !output_.empty();
+}
+
+// the connection has been inactive for too long
+bool Connection::isIdle(std::chrono::steady_clock::time_point now) const
+{
+    return (now - last_activity_) > Constants::Network::idle_timeout;
+}
+
+// record some activity on the connection
+void Connection::touch()
+{
+    last_activity_ = std::chrono::steady_clock::now();
+}
+
+// the connection will be closed once all the data are sent
+bool Connection::isClosing() const
+{
+    return closing_;
+}
+
+// close the connection once all the data are sent
+void Connection::setClosing()
+{
+    closing_ = true;
+}
+
+// some requests of the connection are executed by the workers
+bool Connection::isBusy() const
+{
+    return inflight_ > 0;
+}
+
+// a request waits for the workers, the next ones stay in the socket
+bool Connection::isStalled() const
+{
+    return stalled_;
+}
+
+// stop (or resume) reading the connection
+void Connection::setStalled(bool stalled)
+{
+    stalled_ = stalled;
+}
+
+// the next request waits for the responses, the next ones stay in the socket
+bool Connection::isHeld() const
+{
+    return held_;
+}
+
+// stop reading until a request is dispatched again
+void Connection::setHeld()
+{
+    held_ = true;
+}
+
+// a new request can be sent to the workers
+bool Connection::canDispatch(int lane) const
+{
+    // the client doesn't read its responses
+    if (output_.size() > Constants::Network::max_pending_output)
+        return false;
+
+    if (inflight_ == 0)
+        return true;
+
+    return (lane == lane_) && (inflight_ < Constants::Network::max_pipeline);
+}
+
+// a new request is in flight
+std::uint64_t Connection::dispatch(int lane)
+{
+    inflight_++;
+    lane_ = lane;
+    held_ = false;
+
+    return next_seq_++;
+}
+
+// add the response to the output list once all the previous ones are sent
+void Connection::deliver(Response* response)
+{
+    std::uint64_t seq = response->seq;
+    auto held = reorder_.find(seq);
+
+    // a part of the next response is sent right away, the others are gathered
+    if (response->partial) {
+        if (seq == next_send_) {
+            output_.splice(response->output);
+            delete response;
+            streaming_ = true;
+        } else if (held != reorder_.end()) {
+            held->second->output.splice(response->output);
+            delete response;
+        } else {
+            reorder_[seq] = response;
+        }
+        return;
+    }
+
+    inflight_--;
+
+    // the end of a response whose first parts are waiting
+    if (held != reorder_.end()) {
+        held->second->output.splice(response->output);
+        held->second->partial = false;
+        delete response;
+        response = held->second;
+    }
+
+    // an unordered response is sent right away and leaves a hole in the sequence
+    // (unless it would be sent in the middle of a streamed response)
+    if (!response->ordered && !streaming_) {
+        output_.splice(response->output);
+        delete response;
+        response = nullptr;
+    }
+    reorder_[seq] = response;
+
+    // send all the consecutive responses
+    auto it = reorder_.begin();
+    while ((it != reorder_.end()) && (it->first == next_send_))
+    {
+        // the next response is not complete: send its first parts
+        if (it->second && it->second->partial) {
+            output_.splice(it->second->output);
+            streaming_ = true;
+            break;
+        }
+
+        if (it->second) {
+            output_.splice(it->second->output);
+            delete it->second;
+        }
+
+        it = reorder_.erase(it);
+        next_send_++;
+        streaming_ = false;
+    }
+}
+
+}   //< end namespace
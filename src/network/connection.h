@@ -0,0 +1,94 @@
+/*
+ * @file    connection.h
+ * @brief   Header file for Network Connection class
+ */
+
+// ----- guards
+#ifndef NETWORK_CONNECTION_H
+#define NETWORK_CONNECTION_H
+
+// ----- includes
+#include "../vm/parser.h"
+#include "buffer.h"
+#include "output.h"
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+
+
+// ----- class
+namespace Network
+{
+    class Reactor;
+    struct Response;
+
+    // a non-blocking client connection accepted by the server
+    // several requests can be in flight (pipelining), their responses are
+    // delivered in the order of the requests unless marked as unordered
+    // a response can be streamed in several parts, sent as soon as it is the next one
+    class Connection
+    {
+    public:     //< public methods
+        Connection(int sock, Reactor* reactor);
+        virtual ~Connection();
+
+        // no copy semantics
+        Connection(const Connection&) = delete;
+        Connection& operator=(const Connection&) = delete;
+
+        // no move semantics
+        Connection(Connection&&) = delete;
+        Connection& operator=(Connection&&) = delete;
+
+        int socket() const;
+        std::uint64_t id() const;       //< unique ID (the sockets are reused)
+        Reactor* reactor() const;       //< the reactor serving the connection
+
+        int read();                     //< read all the available data from the socket
+        void receive(const std::uint8_t* pData, std::size_t n);    //< add data received by the reactor
+        int write();                    //< write as much pending data as possible to the socket
+
+        Buffer& input();                //< data received but not yet consumed
+        Output& output();               //< data waiting to be sent
+        VM::Parser& parser();           //< frame parser state for this connection
+
+        bool isPending() const;         //< true if some data are waiting to be sent
+        bool isIdle(std::chrono::steady_clock::time_point now) const;  //< true if inactive for too long
+        void touch();                   //< record some activity on the connection
+        bool isClosing() const;         //< true if the connection should be closed once flushed
+        void setClosing();
+        bool isBusy() const;            //< true while some requests are executed by the workers
+        bool isStalled() const;         //< true while a request waits for the workers to accept it (not read)
+        void setStalled(bool stalled);
+        bool isHeld() const;            //< true while a request waits for the pipeline to drain (not read)
+        void setHeld();
+
+        // requests of different lanes (reads / writes) are never in flight together,
+        // the responses not sent yet count against the pipeline
+        bool canDispatch(int lane) const;
+        std::uint64_t dispatch(int lane);   //< a request is in flight, return its sequence number
+        void deliver(Response* response);   //< queue the response for sending (takes ownership)
+
+    private:    //< private members
+        int socket_;                    //< the client socket
+        std::uint64_t id_;              //< unique ID
+        Reactor* reactor_;              //< owner of the connection
+        bool closing_;                  //< close the connection after the last write
+        bool stalled_;                  //< a request has been refused by the workers
+        bool held_;                     //< a request can't be dispatched until the pipeline drains
+        int inflight_;                  //< number of requests in flight
+        int lane_;                      //< lane of the requests in flight
+        std::uint64_t next_seq_;        //< sequence number of the next request
+        std::uint64_t next_send_;       //< sequence number of the next response to send
+        bool streaming_;                //< the parts of the next response are being sent
+        std::map<std::uint64_t, Response*> reorder_;   //< responses waiting for the previous ones
+        std::chrono::steady_clock::time_point last_activity_;  //< last time data were read or written
+        Buffer input_;                  //< read buffer
+        Output output_;                 //< gathered write list
+        VM::Parser parser_;             //< parser state machine
+    };
+
+}
+
+#endif // NETWORK_CONNECTION_H
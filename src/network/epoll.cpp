@@ -0,0 +1,258 @@
+/*
+ * @file    epoll.cpp
+ * @brief   Source file for Network EpollReactor class
+ */
+
+// ----- includes
+#include "../constants.h"
+#include "epoll.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <iostream>
+
+
+namespace Network
+{
+
+// ----- class
+
+// constructor
+EpollReactor::EpollReactor(int sock) :
+    Reactor(sock), epoll_fd_{-1}
+{ }
+
+// destructor
+/*virtual*/ EpollReactor::~EpollReactor()
+{
+    // the thread must be stopped before the object is destroyed
+    stop();
+}
+
+// main thread function to serve requests
+void EpollReactor::serveRequest()
+{
+    // create epoll instance
+    struct epoll_event event, events[Constants::Network::epoll_max_events];
+    epoll_fd_ = epoll_create1(0);
+    if (epoll_fd_ < 0) {
+        std::cerr << "Error: unable to create the epoll instance!\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    // add the server socket to the monitoring list
+    // the UNIX socket is shared by all the reactors: wake up only one of them
+    event.events = EPOLLIN | EPOLLEXCLUSIVE;
+    event.data.fd = socket_;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, socket_, &event) < 0) {
+        std::cerr << "Error: unable to add server socket to the epoll instance!\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    // and the responses notifications
+    event.events = EPOLLIN;
+    event.data.fd = event_fd_;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, event_fd_, &event) < 0) {
+        std::cerr << "Error: unable to add the eventfd to the epoll instance!\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    // mainloop
+    while (!done_)
+    {
+        // wait for an event (or timeout), not for long if some requests are stalled
+        int timeout = stalled_.empty() ? Constants::Network::epoll_timeout : Constants::Network::stall_retry;
+        int num_events = epoll_wait(epoll_fd_, events, Constants::Network::epoll_max_events, timeout);
+        if (num_events == -1) {
+            if (errno == EINTR)
+                continue;
+
+            std::cerr << "Error: epoll unable to wait for events!\n";
+            std::exit(EXIT_FAILURE);
+        }
+
+        // go through all the event
+        for (int i = 0; i < num_events; ++i)
+        {
+            // new incomming connections
+            if (events[i].data.fd == socket_) {
+                acceptConnections();
+                continue;
+            }
+
+            // responses posted by the workers
+            if (events[i].data.fd == event_fd_) {
+                std::uint64_t value;
+                read(event_fd_, &value, sizeof(value));
+                processResponses();
+                continue;
+            }
+
+            // the connection may have been closed by a previous event
+            auto it = connections_.find(events[i].data.fd);
+            if (it == connections_.end())
+                continue;
+
+            Connection* conn = it->second;
+
+            // error on the socket
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                closeConnection(conn);
+                continue;
+            }
+
+            // some data are available
+            if (events[i].events & EPOLLIN) {
+                readConnection(conn);
+                continue;
+            }
+
+            // the socket is ready to accept more data
+            if (events[i].events & EPOLLOUT) {
+                writeConnection(conn);
+            }
+        }
+
+        // the workers may accept the requests stalled now
+        if (!stalled_.empty()) {
+            retryStalled();
+        }
+
+        // drop the connections without activity
+        closeIdleConnections();
+    }
+
+    // release all the remaining connections
+    flushStalled();
+    closeConnections();
+    close(epoll_fd_);
+    epoll_fd_ = -1;
+}
+
+// accept all the pending connections
+void EpollReactor::acceptConnections()
+{
+    while (true)
+    {
+        struct sockaddr_storage client;
+        socklen_t length = sizeof(client);
+
+        int sock = accept4(socket_, (struct sockaddr*) &client, &length, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (sock < 0) {
+            if (errno == EINTR)
+                continue;
+
+            // no more connections waiting
+            if ((errno != EAGAIN) && (errno != EWOULDBLOCK))
+                std::cerr << "Error: unable to accept incoming connection!\n";
+            return;
+        }
+
+#ifdef DEBUG
+        if (client.ss_family == AF_INET) {
+            struct sockaddr_in* addr = reinterpret_cast<struct sockaddr_in*>(&client);
+            std::cerr << "New connection from " << inet_ntoa(addr->sin_addr);
+            std::cerr << ":" << ntohs(addr->sin_port) << "\n";
+        } else {
+            std::cerr << "New local connection\n";
+        }
+#endif
+
+        // add the socket to the monitoring list
+        struct epoll_event event;
+        event.events = EPOLLIN;
+        event.data.fd = sock;
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, sock, &event) < 0) {
+            std::cerr << "Error: unable to add client socket to the epoll instance!\n";
+            close(sock);
+            continue;
+        }
+
+        connections_[sock] = new Connection(sock, this);
+    }
+}
+
+// read the data from the connection and pass them to the user callback
+void EpollReactor::readConnection(Connection* conn)
+{
+    // read everything available
+    bool closed = (conn->read() < 0);
+
+    // let the user process the data received so far
+    // (a frame may have been completed without going through the buffer)
+    if (callback_ && (!conn->input().empty() || conn->parser().isComplete()))
+        callback_(conn);
+
+    // the peer stopped sending, close once the responses are sent
+    if (closed) {
+        conn->setClosing();
+    }
+
+    // send the response
+    writeConnection(conn);
+}
+
+// flush the pending data of a connection
+void EpollReactor::writeConnection(Connection* conn)
+{
+    if (conn->write() < 0) {
+        closeConnection(conn);
+        return;
+    }
+
+    // the request held is dispatched once the pipeline drains (the connection is read again)
+    if (conn->isHeld() && callback_) {
+        callback_(conn);
+    }
+
+    // everything has been sent
+    if (!conn->isPending() && !conn->isBusy() && conn->isClosing()) {
+        closeConnection(conn);
+        return;
+    }
+
+    updateEvents(conn);
+}
+
+// stop reading once closing (or stalled / held), wait for EPOLLOUT only while some data are pending
+void EpollReactor::updateEvents(Connection* conn)
+{
+    struct epoll_event event;
+    event.events = 0;
+    if (!conn->isClosing() && !conn->isStalled() && !conn->isHeld()) {
+        event.events |= EPOLLIN;
+    }
+    if (conn->isPending()) {
+        event.events |= EPOLLOUT;
+    }
+    event.data.fd = conn->socket();
+    epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, conn->socket(), &event);
+}
+
+// the data received are left in the socket
+void EpollReactor::pauseConnection(Connection* conn)
+{
+    updateEvents(conn);
+}
+
+// the data waiting in the socket are read again (level-triggered)
+void EpollReactor::resumeConnection(Connection* conn)
+{
+    writeConnection(conn);
+}
+
+// close a connection and release its resources
+void EpollReactor::closeConnection(Connection* conn)
+{
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, conn->socket(), nullptr);
+    connections_.erase(conn->socket());
+    delete conn;
+}
+
+}   //< end namespace
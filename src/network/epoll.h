@@ -0,0 +1,50 @@
+/*
+ * @file    epoll.h
+ * @brief   Header file for Network EpollReactor class
+ */
+
+// ----- guards
+#ifndef NETWORK_EPOLL_H
+#define NETWORK_EPOLL_H
+
+// ----- includes
+#include "reactor.h"
+
+
+// ----- class
+namespace Network
+{
+    // reactor based on a level-triggered epoll instance
+    class EpollReactor : public Reactor
+    {
+    public:     //< public methods
+        EpollReactor(int sock);
+        virtual ~EpollReactor();
+
+        // no copy semantics
+        EpollReactor(const EpollReactor&) = delete;
+        EpollReactor& operator=(const EpollReactor&) = delete;
+
+        // no move semantics
+        EpollReactor(EpollReactor&&) = delete;
+        EpollReactor& operator=(EpollReactor&&) = delete;
+
+    protected:  //< protected methods
+        void serveRequest() override;
+        void writeConnection(Connection* conn) override;
+        void closeConnection(Connection* conn) override;
+        void pauseConnection(Connection* conn) override;
+        void resumeConnection(Connection* conn) override;
+
+    private:    //< private methods
+        void acceptConnections();
+        void readConnection(Connection* conn);
+        void updateEvents(Connection* conn);        //< events monitored, depending on the state of the connection
+
+    private:    //< private members
+        int epoll_fd_;                  //< epoll instance
+    };
+
+}
+
+#endif // NETWORK_EPOLL_H
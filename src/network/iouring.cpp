@@ -0,0 +1,432 @@
+/*
+ * @file    iouring.cpp
+ * @brief   Source file for Network URingReactor class
+ */
+
+// ----- includes
+#include "../constants.h"
+#include "iouring.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <iostream>
+
+
+namespace Network
+{
+
+// ----- private types
+
+// connection with the state of its operations in flight
+class URingReactor::URingConnection : public Connection
+{
+public:
+    URingConnection(int sock, Reactor* reactor) :
+        Connection(sock, reactor), pending{0}, receiving{false}, sending{false}, closed{false},
+        inflight{}, iov{}, msg{}
+    { }
+
+    int pending;                //< number of operations in flight
+    bool receiving;             //< a multishot recv is armed
+    bool sending;               //< a sendmsg is in flight
+    bool closed;                //< the connection has been removed from the reactor
+
+    Output inflight;            //< data being sent (not modified until completion)
+    struct iovec iov[Constants::Network::max_iovec];
+    struct msghdr msg;
+};
+
+
+// ----- class
+
+// constructor
+URingReactor::URingReactor(int sock) :
+    Reactor(sock), ring_{}, timeout_{}, retry_timeout_{}, retrying_{false}, event_value_{0}, closed_{}
+{
+    // wake up the mainloop periodically to check the execution flag
+    timeout_.tv_sec = Constants::Network::epoll_timeout / 1000;
+    timeout_.tv_nsec = (Constants::Network::epoll_timeout % 1000) * 1000000L;
+
+    retry_timeout_.tv_sec = Constants::Network::stall_retry / 1000;
+    retry_timeout_.tv_nsec = (Constants::Network::stall_retry % 1000) * 1000000L;
+}
+
+// destructor
+/*virtual*/ URingReactor::~URingReactor()
+{
+    // the thread must be stopped before the object is destroyed
+    stop();
+}
+
+// main thread function to serve requests
+void URingReactor::serveRequest()
+{
+    // the ring waits for the connections itself, no need for a non-blocking socket
+    int flags = fcntl(socket_, F_GETFL, 0);
+    fcntl(socket_, F_SETFL, flags & ~O_NONBLOCK);
+
+    // create the ring and the receive buffers
+    if (!ring_.init(Constants::Network::uring_entries) ||
+        !ring_.initBuffers(Constants::Network::uring_buffers, Constants::Network::uring_buffer_size)) {
+        std::cerr << "Error: unable to create the io_uring instance!\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    prepareAccept();
+    prepareTimeout();
+    prepareEvent();
+
+    // mainloop
+    while (!done_)
+    {
+        // submit all the operations prepared and wait for at least one completion
+        if ((ring_.submit(1) < 0) && (errno != EAGAIN) && (errno != EBUSY)) {
+            std::cerr << "Error: io_uring unable to wait for events!\n";
+            std::exit(EXIT_FAILURE);
+        }
+
+        ring_.forEachCqe([this](struct io_uring_cqe* cqe) { handleCompletion(cqe); });
+    }
+
+    // destroying the ring cancels all the operations in flight
+    flushStalled();
+    closeConnections();
+    ring_.release();
+
+    for (auto* conn : closed_) {
+        delete conn;
+    }
+    closed_.clear();
+}
+
+// return a new submission entry for an operation
+struct io_uring_sqe* URingReactor::getSqe(URingConnection* conn, Operation_t op)
+{
+    struct io_uring_sqe* sqe = ring_.getSqe();
+    if (sqe == nullptr) {
+        std::cerr << "Error: io_uring submission queue is full!\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    // the connections are aligned in memory, the lower bits are free
+    sqe->user_data = reinterpret_cast<std::uint64_t>(conn) | op;
+
+    if (conn) {
+        conn->pending++;
+    }
+
+    return sqe;
+}
+
+// accept all the incoming connections with a single submission
+void URingReactor::prepareAccept()
+{
+    struct io_uring_sqe* sqe = getSqe(nullptr, OP_ACCEPT);
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = socket_;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->accept_flags = SOCK_CLOEXEC;
+}
+
+// wake up the mainloop after a while
+void URingReactor::prepareTimeout()
+{
+    struct io_uring_sqe* sqe = getSqe(nullptr, OP_TIMEOUT);
+    sqe->opcode = IORING_OP_TIMEOUT;
+    sqe->fd = -1;
+    sqe->addr = reinterpret_cast<std::uint64_t>(&timeout_);
+    sqe->len = 1;
+}
+
+// hand over the requests stalled after a while
+void URingReactor::prepareRetry()
+{
+    struct io_uring_sqe* sqe = getSqe(nullptr, OP_RETRY);
+    sqe->opcode = IORING_OP_TIMEOUT;
+    sqe->fd = -1;
+    sqe->addr = reinterpret_cast<std::uint64_t>(&retry_timeout_);
+    sqe->len = 1;
+
+    retrying_ = true;
+}
+
+// wait for the responses posted by the workers
+void URingReactor::prepareEvent()
+{
+    struct io_uring_sqe* sqe = getSqe(nullptr, OP_EVENT);
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = event_fd_;
+    sqe->addr = reinterpret_cast<std::uint64_t>(&event_value_);
+    sqe->len = sizeof(event_value_);
+}
+
+// receive all the data of a connection in the provided buffers
+void URingReactor::prepareRecv(URingConnection* conn)
+{
+    struct io_uring_sqe* sqe = getSqe(conn, OP_RECV);
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = conn->socket();
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = Constants::Network::uring_buffer_group;
+
+    conn->receiving = true;
+}
+
+// send the data in flight with a single gathered write
+void URingReactor::prepareSend(URingConnection* conn)
+{
+    conn->msg = {};
+    conn->msg.msg_iov = conn->iov;
+    conn->msg.msg_iovlen = conn->inflight.prepare(conn->iov, Constants::Network::max_iovec);
+
+    struct io_uring_sqe* sqe = getSqe(conn, OP_SEND);
+    sqe->opcode = IORING_OP_SENDMSG;
+    sqe->fd = conn->socket();
+    sqe->addr = reinterpret_cast<std::uint64_t>(&conn->msg);
+    sqe->len = 1;
+    sqe->msg_flags = MSG_NOSIGNAL;
+
+    conn->sending = true;
+}
+
+// cancel all the operations in flight of a connection
+void URingReactor::prepareCancel(URingConnection* conn)
+{
+    struct io_uring_sqe* sqe = getSqe(conn, OP_CANCEL);
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = conn->socket();
+    sqe->cancel_flags = IORING_ASYNC_CANCEL_FD | IORING_ASYNC_CANCEL_ALL;
+}
+
+// cancel the multishot recv of a connection only (the sends go on)
+void URingReactor::prepareCancelRecv(URingConnection* conn)
+{
+    struct io_uring_sqe* sqe = getSqe(conn, OP_CANCEL);
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = reinterpret_cast<std::uint64_t>(conn) | OP_RECV;
+}
+
+// dispatch a completion to its handler
+void URingReactor::handleCompletion(struct io_uring_cqe* cqe)
+{
+    std::uint64_t op = cqe->user_data & 0x07;
+    URingConnection* conn = reinterpret_cast<URingConnection*>(cqe->user_data & ~0x07ULL);
+
+    switch(op)
+    {
+        case OP_ACCEPT:
+            handleAccept(cqe);
+            break;
+
+        case OP_TIMEOUT:
+            // drop the connections without activity
+            closeIdleConnections();
+            prepareTimeout();
+            break;
+
+        case OP_EVENT:
+            processResponses();
+            prepareEvent();
+            break;
+
+        case OP_RETRY:
+            retrying_ = false;
+            retryStalled();
+            if (!stalled_.empty()) {
+                prepareRetry();
+            }
+            break;
+
+        // the operation is accounted until its handler returns,
+        // a multishot recv until its last completion
+        case OP_RECV:
+            handleRecv(conn, cqe);
+            if (!(cqe->flags & IORING_CQE_F_MORE)) {
+                conn->pending--;
+            }
+            release(conn);
+            break;
+
+        case OP_SEND:
+            handleSend(conn, cqe);
+            conn->pending--;
+            release(conn);
+            break;
+
+        case OP_CANCEL:
+            conn->pending--;
+            release(conn);
+            break;
+    }
+}
+
+// a new connection has been accepted
+void URingReactor::handleAccept(struct io_uring_cqe* cqe)
+{
+    // the multishot accept has been terminated
+    if (!(cqe->flags & IORING_CQE_F_MORE)) {
+        prepareAccept();
+    }
+
+    if (cqe->res < 0) {
+        std::cerr << "Error: unable to accept incoming connection!\n";
+        return;
+    }
+
+    URingConnection* conn = new URingConnection(cqe->res, this);
+    connections_[conn->socket()] = conn;
+
+    prepareRecv(conn);
+}
+
+// some data have been received in a provided buffer
+void URingReactor::handleRecv(URingConnection* conn, struct io_uring_cqe* cqe)
+{
+    // the multishot recv has been terminated
+    if (!(cqe->flags & IORING_CQE_F_MORE)) {
+        conn->receiving = false;
+    }
+
+    // copy the data and give back the buffer immediately
+    if (cqe->flags & IORING_CQE_F_BUFFER) {
+        unsigned bid = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+        if ((cqe->res > 0) && !conn->closed) {
+            conn->receive(ring_.buffer(bid), cqe->res);
+            conn->touch();
+        }
+        ring_.releaseBuffer(bid);
+    }
+
+    if (conn->closed)
+        return;
+
+    // the peer stopped sending or the connection is in error
+    // close once the responses are sent (the recv is canceled while stalled)
+    if ((cqe->res == 0) || ((cqe->res < 0) && (cqe->res != -ENOBUFS) && (cqe->res != -ECANCELED))) {
+        conn->setClosing();
+        writeConnection(conn);
+        return;
+    }
+
+    // let the user process the data received so far
+    if ((cqe->res > 0) && callback_) {
+        callback_(conn);
+    }
+
+    // send the response (and receive again if all the buffers were in use)
+    writeConnection(conn);
+}
+
+// some data have been sent
+void URingReactor::handleSend(URingConnection* conn, struct io_uring_cqe* cqe)
+{
+    conn->sending = false;
+
+    if (conn->closed)
+        return;
+
+    if (cqe->res < 0) {
+        closeConnection(conn);
+        return;
+    }
+
+    conn->inflight.consume(cqe->res);
+    conn->touch();
+
+    // send the remaining data
+    writeConnection(conn);
+}
+
+// send the pending data if no send is already in flight
+void URingReactor::writeConnection(Connection* conn)
+{
+    URingConnection* uconn = static_cast<URingConnection*>(conn);
+    if (uconn->closed)
+        return;
+
+    // the request held is dispatched once the pipeline drains
+    if (uconn->isHeld() && callback_) {
+        callback_(uconn);
+    }
+
+    // receive again unless the connection is paused (or the recv has not been canceled yet)
+    if (!uconn->receiving && !uconn->isClosing() && !uconn->isStalled() && !uconn->isHeld()) {
+        prepareRecv(uconn);
+    }
+
+    if (uconn->sending)
+        return;
+
+    // the previous write has been fully sent: take the pending data
+    if (uconn->inflight.empty()) {
+        if (uconn->output().empty()) {
+            // everything has been sent
+            if (uconn->isClosing() && !uconn->isBusy()) {
+                closeConnection(uconn);
+            }
+            return;
+        }
+
+        uconn->inflight.swap(uconn->output());
+    }
+
+    prepareSend(uconn);
+}
+
+// remove a connection from the reactor
+void URingReactor::closeConnection(Connection* conn)
+{
+    URingConnection* uconn = static_cast<URingConnection*>(conn);
+    if (uconn->closed)
+        return;
+
+    uconn->closed = true;
+    connections_.erase(uconn->socket());
+    closed_.insert(uconn);
+
+    // the socket can't be closed while the kernel is using it
+    if (uconn->receiving || uconn->sending) {
+        prepareCancel(uconn);
+    }
+
+    release(uconn);
+}
+
+// stop receiving until the stalled (or held) request is dispatched
+void URingReactor::pauseConnection(Connection* conn)
+{
+    URingConnection* uconn = static_cast<URingConnection*>(conn);
+    if (uconn->receiving && !uconn->closed) {
+        prepareCancelRecv(uconn);
+    }
+
+    // the requests held are dispatched as the responses are sent
+    if (!stalled_.empty() && !retrying_) {
+        prepareRetry();
+    }
+}
+
+// receive again
+void URingReactor::resumeConnection(Connection* conn)
+{
+    writeConnection(conn);
+}
+
+// delete a closed connection once all its operations are completed
+void URingReactor::release(URingConnection* conn)
+{
+    if (!conn->closed || (conn->pending > 0))
+        return;
+
+    closed_.erase(conn);
+    delete conn;
+}
+
+}   //< end namespace
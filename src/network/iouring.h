@@ -0,0 +1,90 @@
+/*
+ * @file    iouring.h
+ * @brief   Header file for Network URingReactor class
+ */
+
+// ----- guards
+#ifndef NETWORK_IOURING_H
+#define NETWORK_IOURING_H
+
+// ----- includes
+#include "reactor.h"
+#include "uring.h"
+
+#include <linux/time_types.h>
+
+#include <cstdint>
+#include <unordered_set>
+
+
+// ----- class
+namespace Network
+{
+    // reactor based on io_uring: multishot accept, multishot recv in a ring
+    // of provided buffers and gathered sendmsg, all submitted in batches
+    class URingReactor : public Reactor
+    {
+    public:     //< public methods
+        URingReactor(int sock);
+        virtual ~URingReactor();
+
+        // no copy semantics
+        URingReactor(const URingReactor&) = delete;
+        URingReactor& operator=(const URingReactor&) = delete;
+
+        // no move semantics
+        URingReactor(URingReactor&&) = delete;
+        URingReactor& operator=(URingReactor&&) = delete;
+
+    protected:  //< protected methods
+        void serveRequest() override;
+        void writeConnection(Connection* conn) override;        //< send the pending data if no send is in flight
+        void closeConnection(Connection* conn) override;
+        void pauseConnection(Connection* conn) override;        //< cancel the recv
+        void resumeConnection(Connection* conn) override;
+
+    private:    //< private types
+        class URingConnection;
+
+        // operation stored in the lower bits of the user data
+        enum Operation_t : std::uint64_t {
+            OP_ACCEPT = 1,
+            OP_RECV,
+            OP_SEND,
+            OP_CANCEL,
+            OP_TIMEOUT,
+            OP_EVENT,
+            OP_RETRY,                   //< hand over the requests stalled
+        };
+
+    private:    //< private methods
+        struct io_uring_sqe* getSqe(URingConnection* conn, Operation_t op);
+
+        void prepareAccept();
+        void prepareTimeout();
+        void prepareEvent();
+        void prepareRecv(URingConnection* conn);
+        void prepareSend(URingConnection* conn);
+        void prepareCancel(URingConnection* conn);
+        void prepareCancelRecv(URingConnection* conn);
+        void prepareRetry();
+
+        void handleCompletion(struct io_uring_cqe* cqe);
+        void handleAccept(struct io_uring_cqe* cqe);
+        void handleRecv(URingConnection* conn, struct io_uring_cqe* cqe);
+        void handleSend(URingConnection* conn, struct io_uring_cqe* cqe);
+
+        void release(URingConnection* conn);    //< delete the connection once no operation is in flight
+
+    private:    //< private members
+        URing ring_;                                    //< the io_uring instance
+        struct __kernel_timespec timeout_;              //< wake up period of the mainloop
+        struct __kernel_timespec retry_timeout_;        //< wake up period while some requests are stalled
+        bool retrying_;                                 //< the retry timeout is armed
+        std::uint64_t event_value_;                     //< eventfd counter read by the ring
+        std::unordered_set<URingConnection*> closed_;   //< closed connections waiting for their operations
+    };
+
+}
+
+#endif // NETWORK_IOURING_H
@@ -0,0 +1,260 @@
+/*
+ * @file    output.cpp
+ * @brief   Source file for Network Output class
+ */
+
+// ----- includes
+#include "../constants.h"
+#include "output.h"
+
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include <algorithm>
+#include <utility>
+
+
+namespace Network
+{
+
+// ----- class
+
+// constructor
+Output::Output() :
+    buffer_{}, segments_{}, size_{0}
+{ }
+
+// destructor
+Output::~Output()
+{
+    clear();
+}
+
+// copy the data at the end of the list
+void Output::append(const void* pData, std::size_t n)
+{
+    if (n == 0)
+        return;
+
+    buffer_.append(pData, n);
+    size_ += n;
+
+    // merge with the previous inline segment
+    if (!segments_.empty() && (segments_.back().pData == nullptr) && (segments_.back().pArena == nullptr)) {
+        segments_.back().size += n;
+    } else {
+        segments_.push_back(Segment{n, nullptr, nullptr, nullptr});
+    }
+}
+
+// add a block of memory to the list, it will be released once sent
+void Output::attach(std::uint8_t* pData, std::size_t n)
+{
+    if (n == 0) {
+        delete [] pData;
+        return;
+    }
+
+    // small blocks are cheaper to copy than to send in their own iovec
+    if (n < Constants::Network::min_gather_size) {
+        append(pData, n);
+        delete [] pData;
+        return;
+    }
+
+    segments_.push_back(Segment{n, pData, pData, nullptr});
+    size_ += n;
+}
+
+// add a block of memory to the list without taking its ownership
+void Output::reference(const void* pData, std::size_t n)
+{
+    // small blocks are cheaper to copy than to send in their own iovec
+    if (n < Constants::Network::min_gather_size) {
+        append(pData, n);
+        return;
+    }
+
+    segments_.push_back(Segment{n, static_cast<const std::uint8_t*>(pData), nullptr, nullptr});
+    size_ += n;
+}
+
+// keep the arena (referenced by the previous segments) until they are sent
+// an empty segment marks the position of the release
+void Output::hold(VM::Arena* arena)
+{
+    if (size_ == 0) {
+        VM::Arena::release(arena);
+        return;
+    }
+
+    segments_.push_back(Segment{0, nullptr, nullptr, arena});
+}
+
+// free the memory owned by a segment
+void Output::release(Segment& segment)
+{
+    delete [] segment.pOwned;
+    VM::Arena::release(segment.pArena);
+}
+
+// no data waiting to be sent
+bool Output::empty() const
+{
+    return size_ == 0;
+}
+
+// number of bytes waiting to be sent
+std::size_t Output::size() const
+{
+    return size_;
+}
+
+// drop all the data
+void Output::clear()
+{
+    for (auto& segment : segments_) {
+        release(segment);
+    }
+
+    segments_.clear();
+    buffer_.clear();
+    size_ = 0;
+}
+
+// send as much data as possible with gathered writes
+// return the number of bytes sent, or -1 if the socket is in error
+int Output::write(int sock)
+{
+    int total{0};
+
+    while (size_ > 0)
+    {
+        // build the list of blocks to send
+        struct iovec iov[Constants::Network::max_iovec];
+        int count = prepare(iov, Constants::Network::max_iovec);
+
+        // sendmsg() rather than writev() to avoid SIGPIPE
+        struct msghdr msg{};
+        msg.msg_iov = iov;
+        msg.msg_iovlen = count;
+
+        ssize_t n = sendmsg(sock, &msg, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+
+            // the socket buffer is full, try again later
+            if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+                break;
+
+            return -1;
+        }
+
+        consume(n);
+        total += n;
+    }
+
+    return total;
+}
+
+// build the iovec list for the first max segments
+// the pointers stay valid until the list is modified
+int Output::prepare(struct iovec* iov, int max)
+{
+    int count{0};
+    std::uint8_t* pInline = buffer_.data();
+
+    for (auto& segment : segments_)
+    {
+        if (count == max)
+            break;
+
+        // nothing to send (arena marker)
+        if (segment.size == 0)
+            continue;
+
+        if (segment.pData == nullptr) {
+            iov[count].iov_base = pInline;
+            pInline += segment.size;
+        } else {
+            iov[count].iov_base = const_cast<std::uint8_t*>(segment.pData);
+        }
+        iov[count].iov_len = segment.size;
+        count++;
+    }
+
+    return count;
+}
+
+// remove n bytes from the front of the list
+void Output::consume(std::size_t n)
+{
+    size_ -= n;
+
+    while (n > 0)
+    {
+        Segment& segment = segments_.front();
+        std::size_t count = std::min(n, segment.size);
+
+        if (segment.pData == nullptr) {
+            buffer_.consume(count);
+        } else {
+            segment.pData += count;
+        }
+
+        segment.size -= count;
+        n -= count;
+
+        // the segment has been fully sent
+        if (segment.size == 0) {
+            release(segment);
+            segments_.pop_front();
+        }
+    }
+
+    // release the arenas as soon as the data before them have been sent
+    while (!segments_.empty() && (segments_.front().size == 0)) {
+        release(segments_.front());
+        segments_.pop_front();
+    }
+}
+
+// exchange the content of two lists
+void Output::swap(Output& other)
+{
+    buffer_.swap(other.buffer_);
+    segments_.swap(other.segments_);
+    std::swap(size_, other.size_);
+}
+
+// move all the segments of another list at the end of this one
+void Output::splice(Output& other)
+{
+    // nothing to merge with
+    if (empty()) {
+        swap(other);
+        return;
+    }
+
+    std::uint8_t* pInline = other.buffer_.data();
+    for (auto& segment : other.segments_)
+    {
+        if ((segment.pData == nullptr) && (segment.pArena == nullptr)) {
+            append(pInline, segment.size);
+            pInline += segment.size;
+        } else {
+            segments_.push_back(segment);
+            size_ += segment.size;
+        }
+    }
+
+    // the blocks are now owned by this list
+    other.segments_.clear();
+    other.buffer_.clear();
+    other.size_ = 0;
+}
+
+}   //< end namespace
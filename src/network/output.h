@@ -0,0 +1,78 @@
+/*
+ * @file    output.h
+ * @brief   Header file for Network Output class
+ */
+
+// ----- guards
+#ifndef NETWORK_OUTPUT_H
+#define NETWORK_OUTPUT_H
+
+// ----- includes
+#include "../vm/arena.h"
+#include "buffer.h"
+
+#include <sys/uio.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+
+
+// ----- class
+namespace Network
+{
+    // list of memory blocks waiting to be sent with a single gathered write
+    // small blocks are copied in an inline buffer, large blocks are referenced
+    class Output
+    {
+    public:     //< public methods
+        Output();
+        ~Output();
+
+        // no copy semantics
+        Output(const Output&) = delete;
+        Output& operator=(const Output&) = delete;
+
+        // no move semantics
+        Output(Output&&) = delete;
+        Output& operator=(Output&&) = delete;
+
+        void append(const void* pData, std::size_t n);      //< copy the data
+        void attach(std::uint8_t* pData, std::size_t n);    //< take ownership of a block allocated with new[]
+        void reference(const void* pData, std::size_t n);   //< the data must stay valid until sent (see hold())
+        void hold(VM::Arena* arena);                        //< release the arena once the data so far are sent
+
+        bool empty() const;
+        std::size_t size() const;                           //< number of bytes waiting to be sent
+        void clear();
+
+        int write(int sock);                                //< send as much data as possible
+
+        // build the iovec list for the first max segments and return its size
+        int prepare(struct iovec* iov, int max);
+        void consume(std::size_t n);                        //< remove n bytes sent from the front of the list
+
+        void swap(Output& other);                           //< exchange the content of two lists
+        void splice(Output& other);                         //< move the content of another list at the end
+
+    private:    //< private types
+        struct Segment
+        {
+            std::size_t size;               //< number of bytes remaining
+            const std::uint8_t* pData;      //< data to send (nullptr when stored in the inline buffer)
+            std::uint8_t* pOwned;           //< memory released once the segment is sent
+            VM::Arena* pArena;              //< arena released once the segment is sent
+        };
+
+    private:    //< private methods
+        void release(Segment& segment);     //< free the memory owned by a segment
+
+    private:    //< private members
+        Buffer buffer_;                     //< inline segments are stored one after the other
+        std::deque<Segment> segments_;      //< segments in sending order
+        std::size_t size_;                  //< total number of bytes
+    };
+
+}
+
+#endif // NETWORK_OUTPUT_H
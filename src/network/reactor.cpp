@@ -0,0 +1,218 @@
+/*
+ * @file    reactor.cpp
+ * @brief   Source file for Network Reactor class
+ */
+
+// ----- includes
+#include "../constants.h"
+#include "reactor.h"
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <iostream>
+#include <thread>
+
+
+namespace Network
+{
+
+// ----- class
+
+// constructor
+Reactor::Reactor(int sock) :
+    socket_{sock}, thread_{}, done_{true}, callback_{nullptr},
+    event_fd_{-1}, responses_{nullptr}, connections_{}, last_check_{}, stalled_{}
+{
+    event_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (event_fd_ < 0) {
+        std::cerr << "Error: unable to create the eventfd!\n";
+        std::exit(EXIT_FAILURE);
+    }
+}
+
+// destructor
+/*virtual*/ Reactor::~Reactor()
+{
+    stop();
+
+    if (socket_ > 0) {
+        close(socket_);
+        socket_ = -1;
+    }
+
+    // drop the responses never delivered
+    Response* response = responses_.exchange(nullptr);
+    while (response) {
+        Response* next = response->next;
+        delete response;
+        response = next;
+    }
+
+    close(event_fd_);
+}
+
+// set the user callback
+void Reactor::setUserCallback(TCPServerCallback callback)
+{
+    callback_ = callback;
+}
+
+// start the event loop
+void Reactor::start()
+{
+    done_ = false;
+    thread_ = std::thread(&Reactor::serveRequest, this);
+}
+
+// stop the event loop
+void Reactor::stop()
+{
+    done_ = true;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+// add a response to the list and wake up the event loop
+// only the first response posted since the last wake up writes the eventfd
+void Reactor::post(Response* response)
+{
+    Response* head = responses_.load(std::memory_order_relaxed);
+    do {
+        response->next = head;
+    } while (!responses_.compare_exchange_weak(head, response, std::memory_order_release, std::memory_order_relaxed));
+
+    if (head == nullptr) {
+        std::uint64_t value{1};
+        ::write(event_fd_, &value, sizeof(value));
+    }
+}
+
+// deliver the responses to their connections
+// the eventfd must have been read before
+void Reactor::processResponses()
+{
+    Response* list = responses_.exchange(nullptr, std::memory_order_acquire);
+
+    // restore the posting order
+    Response* response{nullptr};
+    while (list) {
+        Response* next = list->next;
+        list->next = response;
+        response = list;
+        list = next;
+    }
+
+    while (response)
+    {
+        Response* next = response->next;
+
+        // the connection may have been closed in the meantime
+        auto it = connections_.find(response->socket);
+        if ((it != connections_.end()) && (it->second->id() == response->id))
+        {
+            Connection* conn = it->second;
+            conn->deliver(response);
+
+            // process the requests waiting for this response
+            if (callback_)
+                callback_(conn);
+
+            writeConnection(conn);
+        } else {
+            delete response;
+        }
+
+        response = next;
+    }
+}
+
+// keep the request until the workers accept it, the connection is not read meanwhile
+// (the storage is never accessed from the reactor)
+void Reactor::stall(Connection* conn, RetryCallback retry)
+{
+    conn->setStalled(true);
+    stalled_.push_back(Stalled{socket: conn->socket(), id: conn->id(), retry: retry});
+    pauseConnection(conn);
+}
+
+// keep the request in the parser until the pipeline drains, the connection is not read meanwhile
+// (its input and its output would grow without limit if the client doesn't read the responses)
+void Reactor::hold(Connection* conn)
+{
+    conn->setHeld();
+    pauseConnection(conn);
+}
+
+// hand over the requests stalled, the connections accepted are read again
+void Reactor::retryStalled()
+{
+    // the callback may stall a connection again
+    std::vector<Stalled> stalled;
+    stalled.swap(stalled_);
+
+    for (auto& request : stalled)
+    {
+        if (!request.retry()) {
+            stalled_.push_back(std::move(request));
+            continue;
+        }
+
+        // the connection may have been closed in the meantime
+        auto it = connections_.find(request.socket);
+        if ((it == connections_.end()) || (it->second->id() != request.id))
+            continue;
+
+        // process the requests received before the stall
+        Connection* conn = it->second;
+        conn->setStalled(false);
+        if (callback_)
+            callback_(conn);
+
+        resumeConnection(conn);
+    }
+}
+
+// the requests already received are executed before stopping (the workers are still running)
+void Reactor::flushStalled()
+{
+    for (auto& request : stalled_) {
+        while (!request.retry()) {
+            std::this_thread::yield();
+        }
+    }
+    stalled_.clear();
+}
+
+// close the connections inactive for too long
+void Reactor::closeIdleConnections()
+{
+    // no need to check more than once per epoll timeout
+    auto now = std::chrono::steady_clock::now();
+    if ((now - last_check_) < std::chrono::milliseconds(Constants::Network::epoll_timeout))
+        return;
+    last_check_ = now;
+
+    auto it = connections_.begin();
+    while (it != connections_.end())
+    {
+        Connection* conn = it->second;
+        ++it;
+
+        // keep the connections still sending / waiting for a response
+        if (conn->isIdle(now) && !conn->isPending() && !conn->isBusy()) {
+            closeConnection(conn);
+        }
+    }
+}
+
+// close all the connections
+void Reactor::closeConnections()
+{
+    while (!connections_.empty()) {
+        closeConnection(connections_.begin()->second);
+    }
+}
+
+}   //< end namespace
@@ -0,0 +1,103 @@
+/*
+ * @file    reactor.h
+ * @brief   Header file for Network Reactor class
+ */
+
+// ----- guards
+#ifndef NETWORK_REACTOR_H
+#define NETWORK_REACTOR_H
+
+// ----- includes
+#include "connection.h"
+#include "response.h"
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+
+// ----- class
+namespace Network
+{
+    // called each time new data are available on a connection
+    using TCPServerCallback = std::function<void(Connection*)>;
+
+    // hand over a request refused by the workers again, true once accepted
+    using RetryCallback = std::function<bool()>;
+
+    // event loop running in its own thread
+    // it accepts and serves the connections of its listening socket
+    // the I/O backend (epoll, io_uring) is provided by the derived classes
+    // the responses built by other threads are posted back through an eventfd
+    class Reactor
+    {
+    public:     //< public methods
+        Reactor(int sock);
+        virtual ~Reactor();
+
+        // no copy semantics
+        Reactor(const Reactor&) = delete;
+        Reactor& operator=(const Reactor&) = delete;
+
+        // no move semantics
+        Reactor(Reactor&&) = delete;
+        Reactor& operator=(Reactor&&) = delete;
+
+        void start();
+        void stop();
+
+        void setUserCallback(TCPServerCallback callback);
+
+        void post(Response* response);                      //< deliver a response (from any thread)
+
+        // the workers are overloaded (from the reactor thread): the connection is not read
+        // anymore, the request is handed over again until accepted then the connection resumes
+        void stall(Connection* conn, RetryCallback retry);
+
+        // the pipeline of the connection is full (from the reactor thread): the connection is
+        // not read anymore, the request is dispatched again as the responses are sent
+        void hold(Connection* conn);
+
+    protected:  //< protected methods
+        virtual void serveRequest() = 0;                    //< thread mainloop
+        virtual void writeConnection(Connection* conn) = 0; //< send the pending data (and resume a held connection)
+        virtual void closeConnection(Connection* conn) = 0;
+        virtual void pauseConnection(Connection* conn) = 0; //< stop reading a connection
+        virtual void resumeConnection(Connection* conn) = 0;
+
+        void closeConnections();
+        void closeIdleConnections();
+        void processResponses();                            //< deliver the responses posted so far
+        void retryStalled();                                //< hand over the requests stalled again
+        void flushStalled();                                //< wait for the workers to accept them all (stopping)
+
+    protected:  //< protected types
+        // request refused by the workers, the connection may be closed meanwhile
+        struct Stalled
+        {
+            int socket;
+            std::uint64_t id;
+            RetryCallback retry;
+        };
+
+    protected:  //< protected members
+        int socket_;                    //< listening socket
+        std::thread thread_;            //< execution thread
+        std::atomic<bool> done_;        //< execution control variable
+
+        TCPServerCallback callback_;    //< user callback
+
+        int event_fd_;                          //< signaled when responses are posted
+        std::atomic<Response*> responses_;      //< responses posted (most recent first)
+
+        std::unordered_map<int, Connection*> connections_;    //< active connections
+        std::chrono::steady_clock::time_point last_check_;    //< last check for idle connections
+        std::vector<Stalled> stalled_;                        //< requests waiting for the workers, in order
+    };
+
+}
+
+#endif // NETWORK_REACTOR_H
@@ -0,0 +1,51 @@
+/*
+ * @file    response.h
+ * @brief   Header file for Network Response structure
+ */
+
+// ----- guards
+#ifndef NETWORK_RESPONSE_H
+#define NETWORK_RESPONSE_H
+
+// ----- includes
+#include "connection.h"
+#include "output.h"
+
+#include <cstdint>
+
+
+// ----- structures
+namespace Network
+{
+    class Reactor;
+
+    // response built outside of the reactor thread and posted back to it
+    // the connection is identified by its socket and its ID as it may be
+    // closed (and the socket reused) before the response is delivered
+    struct Response
+    {
+        Reactor* reactor;               //< the reactor owning the connection
+        int socket;                     //< the client socket
+        std::uint64_t id;               //< the connection ID
+        std::uint64_t seq;              //< position of the request on the connection
+        bool ordered;                   //< false if the response can overtake the previous ones
+        bool partial;                   //< more responses follow for the same request (streaming)
+        Output output;                  //< data to send
+        Response* next;                 //< next response posted to the reactor
+
+        Response(Connection* conn, std::uint64_t seq) :
+            reactor{conn->reactor()}, socket{conn->socket()}, id{conn->id()}, seq{seq}, ordered{true},
+            partial{false}, output{}, next{nullptr}
+        { }
+
+        // a part of the response, posted before it
+        // a streamed response is always ordered: its parts can't be interleaved with other responses
+        Response(const Response* response) :
+            reactor{response->reactor}, socket{response->socket}, id{response->id}, seq{response->seq}, ordered{true},
+            partial{true}, output{}, next{nullptr}
+        { }
+    };
+
+}
+
+#endif // NETWORK_RESPONSE_H
@@ -9,10 +9,14 @@
 #include "server.h"
 
 #include <arpa/inet.h>
+#include <fcntl.h>
 #include <netinet/in.h>
-#include <sys/epoll.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <string.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/un.h>
 #include <unistd.h>
 
 #include <iostream>
@@ -23,34 +27,86 @@ namespace Network
 
 // ----- class
 
-TCPServer::TCPServer(std::string address, std::string port) :
-    Interface(address, port), thread_{}, done_{true}, callback_{nullptr}
+TCPServer::TCPServer(std::string address, std::string port, int threads, std::string backend) :
+    Interface(address, port), reactors_{}, done_{true}, path_{}
 {
-    // bind the socket
-    bindSocket();
+    // the listening sockets are owned by the reactors
+    socket_ = -1;
+    bool uring = selectBackend(backend);
+
+    // one listening socket per reactor, the kernel balances
+    // the incoming connections between them (SO_REUSEPORT)
+    for (int i = 0; i < threads; ++i) {
+        reactors_.push_back(createReactor(bindSocket(), uring));
+    }
+}
+
+TCPServer::TCPServer(std::string path, int threads, std::string backend) :
+    Interface(path, ""), reactors_{}, done_{true}, path_{path}
+{
+    // the listening sockets are owned by the reactors
+    socket_ = -1;
+    bool uring = selectBackend(backend);
+
+    // no SO_REUSEPORT for UNIX sockets: the reactors share the same
+    // listening socket, each one owning a duplicate of the descriptor
+    int sock = bindLocalSocket();
+    for (int i = 0; i < threads; ++i) {
+        int fd = (i == 0) ? sock : fcntl(sock, F_DUPFD_CLOEXEC, 0);
+        if (fd < 0) {
+            std::cerr << "Error: unable to duplicate the server socket!\n";
+            std::exit(EXIT_FAILURE);
+        }
+        reactors_.push_back(createReactor(fd, uring));
+    }
 }
 
 TCPServer::~TCPServer()
 {
-    // wait for the thread
-    if (thread_.joinable()) {
-        std::cerr << "Waiting for Thread to finish...\n";
-        done_ = true;
-        thread_.join();
+    // wait for the threads
+    stop();
+
+    for (auto* reactor : reactors_) {
+        delete reactor;
     }
+    reactors_.clear();
 
-    if (socket_ > 0) {
-        close(socket_);
-        socket_ = -1;
+    // remove the socket file
+    if (path_.size() != 0) {
+        unlink(path_.c_str());
+    }
+}
+
+// check the I/O backend requested by the user
+// io_uring can be missing or disabled: fall back to epoll
+bool TCPServer::selectBackend(std::string backend)
+{
+    bool uring = (backend == "io_uring");
+    if (uring && !URing::isSupported()) {
+        std::cerr << "Warning: io_uring is not supported by the kernel, using epoll\n";
+        uring = false;
+    } else if (!uring && (backend != "epoll")) {
+        std::cerr << "Warning: unknown network backend [" << backend << "], using epoll\n";
     }
+
+    return uring;
+}
+
+// create an event loop for a listening socket
+Reactor* TCPServer::createReactor(int sock, bool uring)
+{
+    if (uring)
+        return new URingReactor(sock);
+
+    return new EpollReactor(sock);
 }
 
-// bind the socket
-void TCPServer::bindSocket()
+// create a new listening socket
+int TCPServer::bindSocket()
 {
     // create the server socket
-    socket_ = socket(AF_INET, SOCK_STREAM, 0);
-    if (socket_ < 0) {
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (sock < 0) {
         std::cerr << "Error: unable to create the server socket!\n";
         std::exit(EXIT_FAILURE);
     }
@@ -78,101 +134,130 @@ void TCPServer::bindSocket()
 
     // set the REUSE flag
     int reuse = 1;
-    if (setsockopt(socket_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(int)) < 0) {
+    if (setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(int)) < 0) {
         std::cerr << "Error: unable to set the REUSE flag on the socket\n";
         std::exit(EXIT_FAILURE);
     }
 
+    // each response is written with a single sendmsg(), there is nothing to
+    // coalesce: don't let Nagle hold it behind a previous one
+    // (the flag is inherited by the accepted sockets)
+    if (setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &reuse, sizeof(int)) < 0) {
+        std::cerr << "Error: unable to set the NODELAY flag on the socket\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    // several sockets can listen on the same port
+    if (setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, &reuse, sizeof(int)) < 0) {
+        std::cerr << "Error: unable to set the REUSEPORT flag on the socket\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    // accept() should never block the event loop
+    int flags = fcntl(sock, F_GETFL, 0);
+    if (fcntl(sock, F_SETFL, flags | O_NONBLOCK) < 0) {
+        std::cerr << "Error: unable to set the server socket in non-blocking mode\n";
+        std::exit(EXIT_FAILURE);
+    }
+
     // bind
-    bind(socket_, (struct sockaddr*)&server_address, sizeof(server_address));
+    if (bind(sock, (struct sockaddr*)&server_address, sizeof(server_address)) < 0) {
+        std::cerr << "Error: unable to bind the server socket [" << address_ << ":" << port_ << "]\n";
+        std::exit(EXIT_FAILURE);
+    }
 
     // listen
-    listen(socket_, Constants::Network::server_listen_max);
+    listen(sock, Constants::Network::server_listen_max);
+
+    return sock;
 }
 
-// serve the request from client
+// create the listening UNIX domain socket
+int TCPServer::bindLocalSocket()
+{
+    sockaddr_un server_address;
+    memset(&server_address, 0, sizeof(server_address));
+    server_address.sun_family = AF_UNIX;
+
+    if (path_.size() >= sizeof(server_address.sun_path)) {
+        std::cerr << "Error: the socket path is too long [" << path_ << "]\n";
+        std::exit(EXIT_FAILURE);
+    }
+    strncpy(server_address.sun_path, path_.c_str(), sizeof(server_address.sun_path) - 1);
+
+    // create the server socket
+    int sock = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (sock < 0) {
+        std::cerr << "Error: unable to create the server socket!\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    // a server is still using the socket
+    int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if ((probe >= 0) && (connect(probe, (struct sockaddr*)&server_address, sizeof(server_address)) == 0)) {
+        std::cerr << "Error: the socket is already in use [" << path_ << "]\n";
+        std::exit(EXIT_FAILURE);
+    }
+    close(probe);
+
+    // remove the socket left by a previous instance
+    unlink(path_.c_str());
+
+    // accept() should never block the event loop
+    int flags = fcntl(sock, F_GETFL, 0);
+    if (fcntl(sock, F_SETFL, flags | O_NONBLOCK) < 0) {
+        std::cerr << "Error: unable to set the server socket in non-blocking mode\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    // bind
+    if (bind(sock, (struct sockaddr*)&server_address, sizeof(server_address)) < 0) {
+        std::cerr << "Error: unable to bind the server socket [" << path_ << "]\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    // listen
+    listen(sock, Constants::Network::server_listen_max);
+
+    return sock;
+}
+
+// set the user callback on all the reactors
 void TCPServer::setUserCallback(TCPServerCallback callback)
 {
-    callback_ = callback;
+    for (auto* reactor : reactors_) {
+        reactor->setUserCallback(callback);
+    }
 }
 
 // start the server
 void TCPServer::start()
 {
-    // start the serving thread
-    std::cerr << "Starting TCP Thread...\n";
+    // the signals are handled by the main thread only
+    sigset_t mask, old_mask;
+    sigfillset(&mask);
+    pthread_sigmask(SIG_BLOCK, &mask, &old_mask);
+
+    // start the serving threads
+    std::cerr << "Starting " << reactors_.size() << " TCP Thread(s)...\n";
     done_ = false;
-    thread_ = std::thread(&TCPServer::serveRequest, this);
+    for (auto* reactor : reactors_) {
+        reactor->start();
+    }
+
+    pthread_sigmask(SIG_SETMASK, &old_mask, nullptr);
 }
 
 // stop the server
 void TCPServer::stop()
 {
     if (!done_) {
-        std::cerr << "Stopping TCP Thread...\n";
+        std::cerr << "Stopping TCP Threads...\n";
         done_ = true;
-        if (thread_.joinable()) {
-            thread_.join();
-        }
-    }
-}
-
-// main thread function to serve requests
-void TCPServer::serveRequest()
-{
-    // create epoll instance
-    struct epoll_event event, events[Constants::Network::epoll_max_events];
-    int epoll_fd = epoll_create1(0);
-    if (epoll_fd < 0) {
-        std::cerr << "Error: unable to create the epoll instance!\n";
-        std::exit(EXIT_FAILURE);
-    }
-
-    // add the server socket to the monitoring list
-    event.events = EPOLLIN;
-    event.data.fd = socket_;
-    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, socket_, &event) < 0) {
-        std::cerr << "Error: unable to add server socket to the epoll instance!\n";
-        std::exit(EXIT_FAILURE);
-    }
-
-    // mainloop
-    while (!done_)
-    {
-        // wait for an event (or timeout)
-        int num_events = epoll_wait(epoll_fd, events, Constants::Network::epoll_max_events, Constants::Network::epoll_timeout);
-        if (num_events == -1) {
-            std::cerr << "Error: epoll unable to wait for events!\n";
-            std::exit(EXIT_FAILURE);
-        }
-
-        // go through all the event
-        for (int i = 0; i < num_events; ++i)
-        {
-            // new incomming connection
-            if (events[i].data.fd == socket_)
-            {
-                struct sockaddr_in client;
-                socklen_t length = sizeof(client);
-
-                int sock = accept(socket_, (struct sockaddr*) &client, &length);
-                if (sock < 0) {
-                    std::cerr << "Error: unable to accept incoming connection!\n";
-                    continue;
-                }
-
-                std::cerr << "New connection from " << inet_ntoa(client.sin_addr);
-                std::cerr << ":" << ntohs(client.sin_port) << "\n";
-
-                // call the user callback if it's defined
-                if (callback_)
-                    callback_(sock);
-
-                // close the connection
-                close(sock);
-            }
+        for (auto* reactor : reactors_) {
+            reactor->stop();
         }
     }
 }
 
-}   //< end namespace
+}   //< end namespace
\ No newline at end of file
@@ -8,23 +8,24 @@
 #define NETWORK_SERVER_H
 
 // ----- includes
+#include "epoll.h"
 #include "interface.h"
+#include "iouring.h"
+#include "reactor.h"
 
-#include <functional>
 #include <string>
-#include <thread>
+#include <vector>
 
 
 // ----- class
 namespace Network
 {
-    using TCPServerCallback = std::function<void(int)>;
-
     class TCPServer : public Interface
     {
     public:     //< public methods
 
-        TCPServer(std::string address, std::string port);
+        TCPServer(std::string address, std::string port, int threads, std::string backend);
+        TCPServer(std::string path, int threads, std::string backend);     //< UNIX domain socket
         virtual ~TCPServer();
 
         // no copy semantics
@@ -41,14 +42,15 @@ namespace Network
         void setUserCallback(TCPServerCallback callback);
 
     private:    //< private methods
-        void serveRequest();
-        void bindSocket();
+        int bindSocket();
+        int bindLocalSocket();
+        bool selectBackend(std::string backend);    //< true if io_uring should be used
+        Reactor* createReactor(int sock, bool uring);
 
     private:    //< private members
-        std::thread thread_;            //< execution thread
-        bool done_;                     //< execution control variable
-
-        TCPServerCallback callback_;    //< user callback
+        std::vector<Reactor*> reactors_;    //< one event loop per thread
+        bool done_;                         //< execution control variable
+        std::string path_;                  //< UNIX socket path (empty for TCP)
     };
 
 }
@@ -0,0 +1,273 @@
+/*
+ * @file    uring.cpp
+ * @brief   Source file for Network URing class
+ */
+
+// ----- includes
+#include "../constants.h"
+#include "uring.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+
+
+// ----- functions
+namespace
+{
+    int io_uring_setup(unsigned entries, struct io_uring_params* params)
+    {
+        return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+    }
+
+    int io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags)
+    {
+        return static_cast<int>(syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+    }
+
+    int io_uring_register(int fd, unsigned opcode, void* arg, unsigned nr_args)
+    {
+        return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, nr_args));
+    }
+}
+
+
+namespace Network
+{
+
+// ----- class
+
+// constructor
+URing::URing() :
+    ring_fd_{-1}, ring_ptr_{nullptr}, ring_size_{0}, sqes_{nullptr}, sqes_size_{0},
+    sq_head_{nullptr}, sq_tail_{nullptr}, sq_array_{nullptr}, sq_mask_{0}, sq_entries_{0}, sq_local_tail_{0},
+    cq_head_{nullptr}, cq_tail_{nullptr}, cq_mask_{0}, cqes_{nullptr},
+    buf_ring_{nullptr}, buf_ring_size_{0}, buffers_{nullptr}, buf_count_{0}, buf_size_{0}
+{ }
+
+// destructor
+URing::~URing()
+{
+    release();
+}
+
+// release all the resources
+void URing::release()
+{
+    if (ring_fd_ >= 0) {
+        close(ring_fd_);
+        ring_fd_ = -1;
+    }
+
+    if (sqes_) {
+        munmap(sqes_, sqes_size_);
+        sqes_ = nullptr;
+    }
+
+    if (ring_ptr_) {
+        munmap(ring_ptr_, ring_size_);
+        ring_ptr_ = nullptr;
+    }
+
+    if (buf_ring_) {
+        munmap(buf_ring_, buf_ring_size_);
+        buf_ring_ = nullptr;
+    }
+
+    delete [] buffers_;
+    buffers_ = nullptr;
+}
+
+// check that the kernel provides everything needed by the reactor
+// (multishot accept / recv and provided buffers rings require Linux 6.0)
+/*static*/ bool URing::isSupported()
+{
+    struct utsname name;
+    if (uname(&name) < 0)
+        return false;
+
+    int major{0}, minor{0};
+    if (sscanf(name.release, "%d.%d", &major, &minor) != 2)
+        return false;
+
+    if (major < 6)
+        return false;
+
+    // try to create a small ring (io_uring can be disabled or filtered)
+    URing ring;
+    return ring.init(8) && ring.initBuffers(8, 4096);
+}
+
+// create the ring
+bool URing::init(unsigned entries)
+{
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+
+    // multishot operations post several completions per submission
+    params.flags = IORING_SETUP_CQSIZE;
+    params.cq_entries = entries * 4;
+
+    ring_fd_ = io_uring_setup(entries, &params);
+    if (ring_fd_ < 0) {
+        ring_fd_ = -1;
+        return false;
+    }
+
+    unsigned required = IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_FAST_POLL;
+    if ((params.features & required) != required) {
+        release();
+        return false;
+    }
+
+    // map the SQ and CQ rings (shared with IORING_FEAT_SINGLE_MMAP)
+    ring_size_ = std::max(
+        params.sq_off.array + params.sq_entries * sizeof(unsigned),
+        params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe)
+    );
+    ring_ptr_ = mmap(nullptr, ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+    if (ring_ptr_ == MAP_FAILED) {
+        ring_ptr_ = nullptr;
+        release();
+        return false;
+    }
+
+    // map the submission entries
+    sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+    void* ptr = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+    if (ptr == MAP_FAILED) {
+        release();
+        return false;
+    }
+    sqes_ = static_cast<struct io_uring_sqe*>(ptr);
+
+    std::uint8_t* p = static_cast<std::uint8_t*>(ring_ptr_);
+
+    sq_head_ = reinterpret_cast<unsigned*>(p + params.sq_off.head);
+    sq_tail_ = reinterpret_cast<unsigned*>(p + params.sq_off.tail);
+    sq_array_ = reinterpret_cast<unsigned*>(p + params.sq_off.array);
+    sq_mask_ = *reinterpret_cast<unsigned*>(p + params.sq_off.ring_mask);
+    sq_entries_ = params.sq_entries;
+    sq_local_tail_ = *sq_tail_;
+
+    cq_head_ = reinterpret_cast<unsigned*>(p + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned*>(p + params.cq_off.tail);
+    cq_mask_ = *reinterpret_cast<unsigned*>(p + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<struct io_uring_cqe*>(p + params.cq_off.cqes);
+
+    return true;
+}
+
+// register a ring of count buffers of size bytes (count must be a power of 2)
+bool URing::initBuffers(unsigned count, unsigned size)
+{
+    // the ring must be page aligned
+    buf_ring_size_ = count * sizeof(struct io_uring_buf);
+    void* ptr = mmap(nullptr, buf_ring_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED)
+        return false;
+    buf_ring_ = static_cast<struct io_uring_buf_ring*>(ptr);
+
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = reinterpret_cast<std::uint64_t>(buf_ring_);
+    reg.ring_entries = count;
+    reg.bgid = Constants::Network::uring_buffer_group;
+
+    if (io_uring_register(ring_fd_, IORING_REGISTER_PBUF_RING, &reg, 1) < 0)
+        return false;
+
+    buffers_ = new std::uint8_t[count * size];
+    buf_count_ = count;
+    buf_size_ = size;
+
+    // hand over all the buffers to the kernel
+    for (unsigned bid = 0; bid < count; ++bid) {
+        releaseBuffer(bid);
+    }
+
+    return true;
+}
+
+// return the next free submission entry (nullptr if the queue is full)
+struct io_uring_sqe* URing::getSqe()
+{
+    unsigned head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+
+    // the submission queue is full: flush it first
+    if (sq_local_tail_ - head >= sq_entries_) {
+        submit(0);
+        head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+        if (sq_local_tail_ - head >= sq_entries_)
+            return nullptr;
+    }
+
+    unsigned index = sq_local_tail_ & sq_mask_;
+    struct io_uring_sqe* sqe = &sqes_[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sq_array_[index] = index;
+    sq_local_tail_++;
+
+    return sqe;
+}
+
+// submit all the pending entries and wait for wait_nr completions
+int URing::submit(unsigned wait_nr)
+{
+    // publish the new entries to the kernel
+    __atomic_store_n(sq_tail_, sq_local_tail_, __ATOMIC_RELEASE);
+    unsigned to_submit = sq_local_tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+
+    unsigned flags = (wait_nr > 0) ? IORING_ENTER_GETEVENTS : 0;
+    int res = io_uring_enter(ring_fd_, to_submit, wait_nr, flags);
+
+    // interrupted: the completions are processed by the caller anyway
+    if ((res < 0) && (errno == EINTR))
+        return 0;
+
+    return res;
+}
+
+// call the function for all the available completions
+void URing::forEachCqe(std::function<void(struct io_uring_cqe*)> fcn)
+{
+    unsigned head = *cq_head_;
+    unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+
+    while (head != tail) {
+        fcn(&cqes_[head & cq_mask_]);
+        head++;
+    }
+
+    // give back the completion entries to the kernel
+    __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+}
+
+// return the address of a provided buffer
+std::uint8_t* URing::buffer(unsigned bid)
+{
+    return buffers_ + (bid * buf_size_);
+}
+
+// give back a provided buffer to the kernel
+void URing::releaseBuffer(unsigned bid)
+{
+    // the entries overlay the ring header: don't use the bufs member,
+    // the flexible array is not placed at offset 0 when compiled as C++
+    unsigned short tail = buf_ring_->tail;
+    struct io_uring_buf* buf = reinterpret_cast<struct io_uring_buf*>(buf_ring_) + (tail & (buf_count_ - 1));
+
+    buf->addr = reinterpret_cast<std::uint64_t>(buffer(bid));
+    buf->len = buf_size_;
+    buf->bid = bid;
+
+    __atomic_store_n(&buf_ring_->tail, static_cast<unsigned short>(tail + 1), __ATOMIC_RELEASE);
+}
+
+}   //< end namespace
@@ -0,0 +1,83 @@
+/*
+ * @file    uring.h
+ * @brief   Header file for Network URing class
+ */
+
+// ----- guards
+#ifndef NETWORK_URING_H
+#define NETWORK_URING_H
+
+// ----- includes
+#include <linux/io_uring.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+
+// ----- class
+namespace Network
+{
+    // thin wrapper around an io_uring instance (raw system calls, no liburing)
+    // with a ring of provided buffers for the receive operations
+    class URing
+    {
+    public:     //< public methods
+        URing();
+        ~URing();
+
+        // no copy semantics
+        URing(const URing&) = delete;
+        URing& operator=(const URing&) = delete;
+
+        // no move semantics
+        URing(URing&&) = delete;
+        URing& operator=(URing&&) = delete;
+
+        // true if the kernel supports all the features used by the reactor
+        static bool isSupported();
+
+        bool init(unsigned entries);                        //< create the ring
+        bool initBuffers(unsigned count, unsigned size);    //< register the provided buffers ring
+
+        struct io_uring_sqe* getSqe();                      //< next free submission entry
+        int submit(unsigned wait_nr);                       //< submit the entries and wait for completions
+
+        // call the function for all the available completions
+        void forEachCqe(std::function<void(struct io_uring_cqe*)> fcn);
+
+        std::uint8_t* buffer(unsigned bid);                 //< address of a provided buffer
+        void releaseBuffer(unsigned bid);                   //< give back a provided buffer to the kernel
+
+        void release();                                     //< destroy the ring (cancel all the operations)
+
+    private:    //< private members
+        int ring_fd_;                       //< io_uring file descriptor
+
+        void* ring_ptr_;                    //< SQ / CQ rings memory
+        std::size_t ring_size_;
+        struct io_uring_sqe* sqes_;         //< submission entries
+        std::size_t sqes_size_;
+
+        unsigned* sq_head_;
+        unsigned* sq_tail_;
+        unsigned* sq_array_;
+        unsigned sq_mask_;
+        unsigned sq_entries_;
+        unsigned sq_local_tail_;            //< entries prepared but not yet published
+
+        unsigned* cq_head_;
+        unsigned* cq_tail_;
+        unsigned cq_mask_;
+        struct io_uring_cqe* cqes_;
+
+        struct io_uring_buf_ring* buf_ring_;    //< provided buffers ring
+        std::size_t buf_ring_size_;
+        std::uint8_t* buffers_;                 //< provided buffers memory
+        unsigned buf_count_;
+        unsigned buf_size_;
+    };
+
+}
+
+#endif // NETWORK_URING_H
@@ -0,0 +1,16 @@
+/*
+ * @file    storage.h
+ * @brief   Aggreggate storage headers
+ */
+
+// ----- guards
+#ifndef STORAGE_H
+#define STORAGE_H
+
+#include "storage/engine.h"
+#include "storage/log.h"
+#include "storage/memory.h"
+#include "storage/ordered.h"
+#include "storage/wheel.h"
+
+#endif // STORAGE_H
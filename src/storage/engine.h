@@ -0,0 +1,115 @@
+/*
+ * @file    engine.h
+ * @brief   Header file for the Storage Engine interface
+ */
+
+// ----- guards
+#ifndef STORAGE_ENGINE_H
+#define STORAGE_ENGINE_H
+
+// ----- includes
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+
+
+// ----- structures
+struct DBResult
+{
+    int size;
+    std::uint8_t* pData;
+    std::int64_t expiry;            //< 0: no expiry
+
+    ~DBResult() {
+        delete [] pData;
+    }
+};
+
+// ----- class
+namespace Storage
+{
+    // the key of a user, the data is owned by the caller
+    struct Key
+    {
+        int uid;
+        std::string_view key;
+
+        bool operator==(const Key& other) const {
+            return (uid == other.uid) && (key == other.key);
+        }
+    };
+
+    struct KeyHash
+    {
+        std::size_t operator()(const Key& key) const {
+            std::size_t hash = std::hash<std::string_view>{}(key.key);
+            return hash ^ (static_cast<std::size_t>(key.uid) * 0x9E3779B97F4A7C15ULL);
+        }
+    };
+
+    inline Key makeKey(const std::uint8_t* key, int ksize, int uid)
+    {
+        return Key{uid, std::string_view(reinterpret_cast<const char*>(key), ksize)};
+    }
+
+    // called for each key found by a scan, false to stop the scan
+    using ScanCallback = std::function<bool(const std::uint8_t* key, int ksize)>;
+
+    // called for each key deleted by a purge
+    using PurgeCallback = std::function<void(int uid, const std::uint8_t* key, int ksize)>;
+
+    // the key / value store of the users, a key is identified by (uid, key)
+    // the reads can run concurrently, the writes come from a single thread at a time
+    // the expired keys are never returned
+    class Engine
+    {
+    public:     //< public methods
+        Engine() = default;
+        virtual ~Engine() = default;
+
+        // no copy semantics
+        Engine(const Engine&) = delete;
+        Engine& operator=(const Engine&) = delete;
+
+        // no move semantics
+        Engine(Engine&&) = delete;
+        Engine& operator=(Engine&&) = delete;
+
+        // operations
+        virtual DBResult* get(const std::uint8_t* key, int ksize, int uid) = 0;     //< nullptr if not found
+        virtual bool set(const std::uint8_t* key, int ksize, const std::uint8_t* value, int vsize, int uid) = 0;    //< clears the expiry
+        virtual bool exists(const std::uint8_t* key, int ksize, int uid) = 0;
+        virtual bool remove(const std::uint8_t* key, int ksize, int uid) = 0;
+
+        // read several keys at once, from the same state of the storage
+        // results[i] is nullptr if keys[i] is not found
+        virtual void getMany(const Key* keys, int count, DBResult** results) = 0;
+
+        // read a key to modify it (writer only): the writes of the current batch are seen
+        virtual DBResult* getForUpdate(const std::uint8_t* key, int ksize, int uid) = 0;
+
+        // the deadline is in seconds since the epoch, 0 to keep the key forever
+        virtual bool expire(const std::uint8_t* key, int ksize, int uid, std::int64_t deadline) = 0;
+
+        // delete up to limit keys expired at now, return the number of keys deleted
+        // the expired keys are invisible before, the purge only reclaims their space
+        virtual int purge(std::int64_t now, int limit, PurgeCallback callback) = 0;
+
+        // list the keys of a user starting with the prefix, in order
+        // the callback can't use the engine
+        virtual void scan(const std::uint8_t* prefix, int psize, int uid, ScanCallback callback) = 0;
+
+        // list the keys of a user in order, after the key given (from the first key if nullptr)
+        // the listing is resumed from the last key returned: the engine keeps no state
+        virtual void list(const std::uint8_t* after, int asize, int uid, ScanCallback callback) = 0;
+
+        // group the next writes of the calling thread (batch operations)
+        // the other threads can't write until commit()
+        virtual void begin() = 0;
+        virtual bool commit() = 0;          //< false if the writes have been rolled back
+    };
+
+}
+
+#endif // STORAGE_ENGINE_H
@@ -0,0 +1,904 @@
+/*
+ * @file    log.cpp
+ * @brief   Source file for the Storage LogEngine class
+ */
+
+// ----- includes
+#include "../constants.h"
+#include "log.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <iostream>
+
+
+// ----- functions
+namespace
+{
+    // CRC-32 (IEEE) of the records, to detect a torn write at the end of a segment
+    std::uint32_t crc32(std::uint32_t crc, const std::uint8_t* data, std::size_t size)
+    {
+        static const std::array<std::uint32_t, 256> table = [] {
+            std::array<std::uint32_t, 256> values{};
+            for (std::uint32_t i = 0; i < 256; ++i) {
+                std::uint32_t value = i;
+                for (int bit = 0; bit < 8; ++bit) {
+                    value = (value & 1) ? (0xEDB88320U ^ (value >> 1)) : (value >> 1);
+                }
+                values[i] = value;
+            }
+            return values;
+        }();
+
+        crc = ~crc;
+        for (std::size_t i = 0; i < size; ++i) {
+            crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        }
+        return ~crc;
+    }
+
+    // write a whole buffer, false on error
+    bool writeAll(int fd, const std::uint8_t* data, std::size_t size)
+    {
+        while (size > 0)
+        {
+            ssize_t count = write(fd, data, size);
+            if (count < 0) {
+                if (errno == EINTR)
+                    continue;
+                return false;
+            }
+            data += count;
+            size -= count;
+        }
+
+        return true;
+    }
+
+    // read a whole file in memory, false on error
+    bool readAll(const std::string& path, std::vector<std::uint8_t>& data)
+    {
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            return false;
+
+        struct stat st{};
+        bool result = (fstat(fd, &st) == 0);
+        if (result) {
+            data.resize(st.st_size);
+            result = (pread(fd, data.data(), data.size(), 0) == static_cast<ssize_t>(data.size()));
+        }
+
+        close(fd);
+        return result;
+    }
+}
+
+
+namespace Storage
+{
+
+// ----- class
+
+// constructor
+// the directory is created if needed, the index is rebuilt from the segments
+LogEngine::LogEngine(std::string directory) :
+    Engine(), directory_{directory}, mutex_{}, writer_{}, index_{}, ordered_{}, segments_{}, active_{nullptr}, wheel_{}, expired_{},
+    thread_{}, compact_mutex_{}, compact_cond_{}, done_{false}
+{
+    std::error_code error;
+    std::filesystem::create_directories(directory_, error);
+    if (error) {
+        std::cerr << "Error: unable to create the storage directory [" << directory_ << "]\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    std::cout << "Using storage directory [" << directory_ << "]\n";
+    loadSegments();
+
+    thread_ = std::thread(&LogEngine::compactLoop, this);
+}
+
+// destructor
+/*virtual*/ LogEngine::~LogEngine()
+{
+    {
+        std::lock_guard<std::mutex> lock(compact_mutex_);
+        done_ = true;
+    }
+    compact_cond_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+
+    ordered_.clear();
+    for (auto& it : index_) {
+        delete it.second;
+    }
+    index_.clear();
+
+    for (auto& it : segments_) {
+        close(it.second->fd);
+        delete it.second;
+    }
+    segments_.clear();
+}
+
+// path of a file of a segment
+std::string LogEngine::path(std::uint32_t id, const char* extension) const
+{
+    char name[32];
+    snprintf(name, sizeof(name), "%08u%s", id, extension);
+    return (std::filesystem::path(directory_) / name).string();
+}
+
+// open the data file of a segment, nullptr on error
+LogEngine::Segment* LogEngine::openSegment(std::uint32_t id, bool create)
+{
+    int flags = O_RDWR | O_APPEND | O_CLOEXEC | (create ? O_CREAT : 0);
+    int fd = open(path(id, ".data").c_str(), flags, 0644);
+    if (fd < 0)
+        return nullptr;
+
+    struct stat st{};
+    fstat(fd, &st);
+
+    return new Segment{
+        id: id,
+        fd: fd,
+        size: static_cast<std::uint64_t>(st.st_size),
+        dead: 0
+    };
+}
+
+// rebuild the index from the segments, in the order they were written
+// the last segment is written again if it is not full
+void LogEngine::loadSegments()
+{
+    std::vector<std::uint32_t> ids;
+    for (auto& entry : std::filesystem::directory_iterator(directory_))
+    {
+        if (entry.path().extension() != ".data")
+            continue;
+
+        // the temporary files of an interrupted compaction are dropped
+        std::string stem = entry.path().stem().string();
+        if (stem.find_first_not_of("0123456789") == std::string::npos) {
+            ids.push_back(static_cast<std::uint32_t>(std::stoul(stem)));
+        }
+    }
+    for (auto& entry : std::filesystem::directory_iterator(directory_)) {
+        if (entry.path().extension() == ".compact") {
+            std::filesystem::remove(entry.path());
+        }
+    }
+    std::sort(ids.begin(), ids.end());
+
+    for (auto id : ids)
+    {
+        Segment* segment = openSegment(id, false);
+        if (segment == nullptr) {
+            std::cerr << "Error: unable to open the segment [" << path(id, ".data") << "]\n";
+            std::exit(EXIT_FAILURE);
+        }
+        segments_[id] = segment;
+
+        if (!loadHint(segment)) {
+            loadRecords(segment);
+        }
+    }
+
+    if (!segments_.empty() && (segments_.rbegin()->second->size < Constants::Storage::segment_size)) {
+        active_ = segments_.rbegin()->second;
+        return;
+    }
+
+    std::uint32_t id = segments_.empty() ? 1 : segments_.rbegin()->first + 1;
+    active_ = openSegment(id, true);
+    if (active_ == nullptr) {
+        std::cerr << "Error: unable to create the segment [" << path(id, ".data") << "]\n";
+        std::exit(EXIT_FAILURE);
+    }
+    segments_[id] = active_;
+}
+
+// rebuild the index of a compacted segment from its hint file
+// false if there is no hint for this version of the segment
+bool LogEngine::loadHint(Segment* segment)
+{
+    std::vector<std::uint8_t> data;
+    if (!readAll(path(segment->id, ".hint"), data) || (data.size() < sizeof(HintHeader)))
+        return false;
+
+    HintHeader hint{};
+    memcpy(&hint, data.data(), sizeof(hint));
+    if ((hint.magic != Constants::Storage::hint_magic) || (hint.size != segment->size))
+        return false;
+
+    std::size_t offset = sizeof(HintHeader);
+    while (offset + sizeof(HintEntry) <= data.size())
+    {
+        HintEntry entry{};
+        memcpy(&entry, data.data() + offset, sizeof(entry));
+        offset += sizeof(entry);
+        if (offset + entry.ksize > data.size())
+            break;
+
+        // the compacted segments only contain values
+        RecordHeader header{};
+        header.type = R_PUT;
+        header.uid = entry.uid;
+        header.ksize = entry.ksize;
+        header.vsize = entry.vsize;
+        header.expiry = entry.expiry;
+        apply(segment, entry.offset, header, data.data() + offset);
+
+        offset += entry.ksize;
+    }
+
+    return true;
+}
+
+// rebuild the index from the records of a segment
+// an incomplete record (interrupted write) ends the segment
+void LogEngine::loadRecords(Segment* segment)
+{
+    if (segment->size == 0)
+        return;
+
+    void* map = mmap(nullptr, segment->size, PROT_READ, MAP_PRIVATE, segment->fd, 0);
+    if (map == MAP_FAILED) {
+        std::cerr << "Error: unable to read the segment [" << path(segment->id, ".data") << "]\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    const std::uint8_t* data = static_cast<const std::uint8_t*>(map);
+    std::uint64_t offset{0};
+
+    while (offset + sizeof(RecordHeader) <= segment->size)
+    {
+        RecordHeader header{};
+        memcpy(&header, data + offset, sizeof(header));
+
+        std::uint64_t size = sizeof(RecordHeader) + static_cast<std::uint64_t>(header.ksize) + header.vsize;
+        if (offset + size > segment->size)
+            break;
+
+        std::uint32_t crc = crc32(0, data + offset + sizeof(header.crc), size - sizeof(header.crc));
+        if (crc != header.crc)
+            break;
+
+        apply(segment, offset, header, data + offset + sizeof(RecordHeader));
+        offset += size;
+    }
+
+    munmap(map, segment->size);
+
+    // drop the end of the segment, the next records are appended after the last valid one
+    if (offset != segment->size) {
+        std::cerr << "Warning: segment [" << path(segment->id, ".data") << "] truncated at " << offset << "\n";
+        if (ftruncate(segment->fd, offset) != 0) {
+            std::cerr << "Error: unable to truncate the segment\n";
+            std::exit(EXIT_FAILURE);
+        }
+        segment->size = offset;
+    }
+}
+
+// apply a record to the index
+void LogEngine::apply(Segment* segment, std::uint64_t offset, const RecordHeader& header, const std::uint8_t* key)
+{
+    std::uint64_t size = sizeof(RecordHeader) + static_cast<std::uint64_t>(header.ksize) + header.vsize;
+    auto it = index_.find(makeKey(key, header.ksize, header.uid));
+    Location* location = (it != index_.end()) ? it->second : nullptr;
+
+    switch(header.type)
+    {
+        case R_PUT:
+            if (location == nullptr) {
+                location = new Location{};
+                location->ksize = header.ksize;
+                location->pKey = new std::uint8_t[header.ksize];
+                memcpy(location->pKey, key, header.ksize);
+                Key owned = makeKey(location->pKey, location->ksize, header.uid);
+                index_[owned] = location;
+                ordered_.insert(header.uid, owned.key, location);
+            } else {
+                release(location);
+            }
+            location->segment = segment->id;
+            location->offset = offset;
+            location->vsize = header.vsize;
+            location->expiry = header.expiry;
+            if (header.expiry != 0) {
+                wheel_.schedule(header.uid, key, header.ksize, header.expiry);
+            }
+            break;
+
+        case R_DELETE:
+            segment->dead += size;
+            if (location != nullptr) {
+                release(location);
+                ordered_.erase(header.uid, it->first.key);
+                index_.erase(it);
+                delete location;
+            }
+            break;
+
+        case R_EXPIRE:
+            segment->dead += size;
+            if (location != nullptr) {
+                location->expiry = header.expiry;
+                if (header.expiry != 0) {
+                    wheel_.schedule(header.uid, key, header.ksize, header.expiry);
+                }
+            }
+            break;
+    }
+}
+
+// the record of a location is not the latest one anymore
+void LogEngine::release(Location* location)
+{
+    auto it = segments_.find(location->segment);
+    if (it != segments_.end()) {
+        it->second->dead += sizeof(RecordHeader) + static_cast<std::uint64_t>(location->ksize) + location->vsize;
+    }
+}
+
+// return the location of a key still alive, the index must be locked
+LogEngine::Location* LogEngine::find(const std::uint8_t* key, int ksize, int uid)
+{
+    auto it = index_.find(makeKey(key, ksize, uid));
+    if (it == index_.end())
+        return nullptr;
+
+    // an expired key stays in the index until the compaction
+    Location* location = it->second;
+    if ((location->expiry != 0) && (location->expiry <= std::time(nullptr)))
+        return nullptr;
+
+    return location;
+}
+
+// start a new segment once the active one is full
+// the writer lock must be held
+void LogEngine::rotate()
+{
+    if (active_->size < Constants::Storage::segment_size)
+        return;
+
+    std::uint32_t id = active_->id + 1;
+    Segment* segment = openSegment(id, true);
+    if (segment == nullptr) {
+        std::cerr << "Error: unable to create the segment [" << path(id, ".data") << "]\n";
+        return;
+    }
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    segments_[id] = segment;
+    active_ = segment;
+}
+
+// append a record to the active segment with a single write
+// the writer lock must be held
+bool LogEngine::append(Record_t type, const std::uint8_t* key, int ksize, const std::uint8_t* value, int vsize,
+                       int uid, std::int64_t expiry, std::uint64_t& offset)
+{
+    rotate();
+
+    RecordHeader header{};
+    header.type = type;
+    header.uid = uid;
+    header.ksize = ksize;
+    header.vsize = vsize;
+    header.expiry = expiry;
+
+    std::uint32_t crc = crc32(0, reinterpret_cast<const std::uint8_t*>(&header) + sizeof(header.crc), sizeof(header) - sizeof(header.crc));
+    crc = crc32(crc, key, ksize);
+    header.crc = crc32(crc, value, vsize);
+
+    struct iovec iov[3] = {
+        { &header, sizeof(header) },
+        { const_cast<std::uint8_t*>(key), static_cast<std::size_t>(ksize) },
+        { const_cast<std::uint8_t*>(value), static_cast<std::size_t>(vsize) },
+    };
+    std::size_t size = sizeof(header) + ksize + vsize;
+
+    // the record is written in one piece or not at all
+    ssize_t count = writev(active_->fd, iov, (vsize > 0) ? 3 : 2);
+    if (count != static_cast<ssize_t>(size)) {
+        std::cerr << "Error: unable to write in the segment [" << path(active_->id, ".data") << "]\n";
+        if (ftruncate(active_->fd, active_->size) != 0) {
+            std::cerr << "Error: unable to truncate the segment\n";
+        }
+        return false;
+    }
+
+    offset = active_->size;
+    active_->size += size;
+    return true;
+}
+
+// read the value of a key with a single pread
+/*virtual*/ DBResult* LogEngine::get(const std::uint8_t* key, int ksize, int uid)
+{
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return read(find(key, ksize, uid));
+}
+
+// read the values of several keys, the index is locked once
+/*virtual*/ void LogEngine::getMany(const Key* keys, int count, DBResult** results)
+{
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+
+    for (int i = 0; i < count; ++i) {
+        const Key& key = keys[i];
+        results[i] = read(find(reinterpret_cast<const std::uint8_t*>(key.key.data()), key.key.size(), key.uid));
+    }
+}
+
+// the index is updated with each append: the value is the current one
+/*virtual*/ DBResult* LogEngine::getForUpdate(const std::uint8_t* key, int ksize, int uid)
+{
+    return get(key, ksize, uid);
+}
+
+// read the value of a location, the index must be locked
+DBResult* LogEngine::read(const Location* location)
+{
+    if (location == nullptr)
+        return nullptr;
+
+    DBResult* result = new DBResult{
+        size: location->vsize,
+        pData: new std::uint8_t[location->vsize],
+        expiry: location->expiry
+    };
+
+    int fd = segments_.at(location->segment)->fd;
+    std::uint64_t offset = location->offset + sizeof(RecordHeader) + location->ksize;
+    if (pread(fd, result->pData, location->vsize, offset) != location->vsize) {
+        std::cerr << "Error: unable to read the segment [" << path(location->segment, ".data") << "]\n";
+        delete result;
+        return nullptr;
+    }
+
+    return result;
+}
+
+// add a key/value (or replace the value of the key)
+/*virtual*/ bool LogEngine::set(const std::uint8_t* key, int ksize, const std::uint8_t* value, int vsize, int uid)
+{
+    std::lock_guard<std::recursive_mutex> writer(writer_);
+
+    std::uint64_t offset{0};
+    if (!append(R_PUT, key, ksize, value, vsize, uid, 0, offset))
+        return false;
+
+    RecordHeader header{};
+    header.type = R_PUT;
+    header.uid = uid;
+    header.ksize = ksize;
+    header.vsize = vsize;
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    apply(active_, offset, header, key);
+    return true;
+}
+
+// check if a key exists
+/*virtual*/ bool LogEngine::exists(const std::uint8_t* key, int ksize, int uid)
+{
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return (find(key, ksize, uid) != nullptr);
+}
+
+// delete a key with a tombstone
+/*virtual*/ bool LogEngine::remove(const std::uint8_t* key, int ksize, int uid)
+{
+    std::lock_guard<std::recursive_mutex> writer(writer_);
+
+    // only the writer modifies the index
+    bool alive{false};
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        if (index_.find(makeKey(key, ksize, uid)) == index_.end())
+            return false;
+        alive = (find(key, ksize, uid) != nullptr);
+    }
+
+    std::uint64_t offset{0};
+    if (!append(R_DELETE, key, ksize, nullptr, 0, uid, 0, offset))
+        return false;
+
+    RecordHeader header{};
+    header.type = R_DELETE;
+    header.uid = uid;
+    header.ksize = ksize;
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    apply(active_, offset, header, key);
+    return alive;
+}
+
+// set the expiry of a key
+/*virtual*/ bool LogEngine::expire(const std::uint8_t* key, int ksize, int uid, std::int64_t deadline)
+{
+    std::lock_guard<std::recursive_mutex> writer(writer_);
+
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        if (find(key, ksize, uid) == nullptr)
+            return false;
+    }
+
+    std::uint64_t offset{0};
+    if (!append(R_EXPIRE, key, ksize, nullptr, 0, uid, deadline, offset))
+        return false;
+
+    RecordHeader header{};
+    header.type = R_EXPIRE;
+    header.uid = uid;
+    header.ksize = ksize;
+    header.expiry = deadline;
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    apply(active_, offset, header, key);
+    return true;
+}
+
+// list the keys of a user starting with the prefix
+// the range of the prefix is walked in the ordered index
+/*virtual*/ void LogEngine::scan(const std::uint8_t* prefix, int psize, int uid, ScanCallback callback)
+{
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    std::int64_t now = std::time(nullptr);
+    std::string_view start(reinterpret_cast<const char*>(prefix), psize);
+
+    ordered_.visit(uid, start, false, [&](std::string_view key, Location* location) {
+        if (key.substr(0, start.size()) != start)
+            return false;
+
+        if ((location->expiry != 0) && (location->expiry <= now))
+            return true;
+
+        return callback(location->pKey, location->ksize);
+    });
+}
+
+// list the keys of a user in order, after a key
+/*virtual*/ void LogEngine::list(const std::uint8_t* after, int asize, int uid, ScanCallback callback)
+{
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    std::int64_t now = std::time(nullptr);
+    std::string_view start(reinterpret_cast<const char*>(after), (after != nullptr) ? asize : 0);
+
+    ordered_.visit(uid, start, (after != nullptr), [&](std::string_view, Location* location) {
+        if ((location->expiry != 0) && (location->expiry <= now))
+            return true;
+
+        return callback(location->pKey, location->ksize);
+    });
+}
+
+// drop the keys whose timer is due (and still expired) from the index
+// like the compaction, no tombstone is written: an expired record never comes back
+/*virtual*/ int LogEngine::purge(std::int64_t now, int limit, PurgeCallback callback)
+{
+    std::lock_guard<std::recursive_mutex> writer(writer_);
+    int count{0};
+
+    wheel_.advance(now, expired_);
+    while (!expired_.empty() && (count < limit))
+    {
+        TimingWheel::Timer timer = std::move(expired_.back());
+        expired_.pop_back();
+
+        Location* location{nullptr};
+        {
+            std::unique_lock<std::shared_mutex> lock(mutex_);
+            auto it = index_.find(Key{timer.uid, timer.key});
+            if ((it == index_.end()) || (it->second->expiry == 0) || (it->second->expiry > now))
+                continue;
+
+            location = it->second;
+            release(location);
+            index_.erase(it);
+            ordered_.erase(timer.uid, timer.key);
+        }
+
+        callback(timer.uid, location->pKey, location->ksize);
+        delete location;
+        count++;
+    }
+
+    return count;
+}
+
+// the records are appended at once, a batch keeps the other writers out
+/*virtual*/ void LogEngine::begin()
+{
+    writer_.lock();
+}
+
+// the records of the batch reach the disk with a single sync (if requested)
+/*virtual*/ bool LogEngine::commit()
+{
+    bool result{true};
+
+    if (Constants::Storage::log_sync && (fdatasync(active_->fd) != 0)) {
+        std::cerr << "Error: unable to sync the segment [" << path(active_->id, ".data") << "]\n";
+        result = false;
+    }
+
+    writer_.unlock();
+    return result;
+}
+
+// compaction thread mainloop
+void LogEngine::compactLoop()
+{
+    while (!done_)
+    {
+        {
+            std::unique_lock<std::mutex> lock(compact_mutex_);
+            compact_cond_.wait_for(lock, Constants::Storage::compaction_interval, [this] { return done_.load(); });
+        }
+
+        if (!done_ && needsCompaction()) {
+            compact();
+        }
+    }
+}
+
+// check the ratio of dead records in the old segments
+bool LogEngine::needsCompaction()
+{
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    std::uint64_t size{0};
+    std::uint64_t dead{0};
+
+    for (auto& it : segments_) {
+        if (it.second != active_) {
+            size += it.second->size;
+            dead += it.second->dead;
+        }
+    }
+
+    return (size > 0) && (dead >= size * Constants::Storage::compaction_ratio);
+}
+
+// copy the live records of all the old segments in new segments
+// all the segments older than the active one are compacted together:
+// a tombstone can be dropped as no older segment is left with the key
+void LogEngine::compact()
+{
+    std::vector<LiveRecord> records;
+    std::vector<std::uint32_t> inputs;
+    std::unordered_map<std::uint32_t, int> fds;
+
+    // snapshot of the live records, the old segments are never written again
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        for (auto& it : segments_) {
+            if (it.second != active_) {
+                inputs.push_back(it.first);
+                fds[it.first] = it.second->fd;
+            }
+        }
+
+        for (auto& it : index_) {
+            const Location* location = it.second;
+            if (fds.find(location->segment) == fds.end())
+                continue;
+
+            records.push_back(LiveRecord{
+                uid: it.first.uid,
+                key: std::string(it.first.key),
+                segment: location->segment,
+                offset: location->offset,
+                vsize: location->vsize,
+                expiry: location->expiry,
+                target: 0,
+                target_offset: 0
+            });
+        }
+    }
+
+    // read the old segments sequentially
+    std::sort(records.begin(), records.end(), [](const LiveRecord& a, const LiveRecord& b) {
+        return (a.segment != b.segment) ? (a.segment < b.segment) : (a.offset < b.offset);
+    });
+
+    std::vector<std::uint32_t> outputs;
+    if (!writeCompacted(records, inputs, fds, outputs))
+        return;
+
+    // the records modified meanwhile keep their new location
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    std::unordered_map<std::uint32_t, std::uint64_t> dead;
+
+    for (auto& record : records)
+    {
+        std::uint64_t size = sizeof(RecordHeader) + record.key.size() + record.vsize;
+        auto it = index_.find(Key{record.uid, record.key});
+        bool current = (it != index_.end()) && (it->second->segment == record.segment) && (it->second->offset == record.offset);
+
+        // the expired keys are gone
+        if (record.target == 0) {
+            if (current) {
+                ordered_.erase(record.uid, record.key);
+                delete it->second;
+                index_.erase(it);
+            }
+            continue;
+        }
+
+        if (current) {
+            it->second->segment = record.target;
+            it->second->offset = record.target_offset;
+        } else {
+            dead[record.target] += size;
+        }
+    }
+
+    // replace the old segments, the lowest IDs are reused so the order is kept
+    for (auto id : inputs) {
+        close(segments_[id]->fd);
+        delete segments_[id];
+        segments_.erase(id);
+    }
+
+    for (auto id : inputs)
+    {
+        bool reused = (std::find(outputs.begin(), outputs.end(), id) != outputs.end());
+
+        // a hint must never describe another version of the segment
+        unlink(path(id, ".hint").c_str());
+        if (!reused) {
+            unlink(path(id, ".data").c_str());
+            continue;
+        }
+
+        if ((rename(path(id, ".data.compact").c_str(), path(id, ".data").c_str()) != 0) ||
+            (rename(path(id, ".hint.compact").c_str(), path(id, ".hint").c_str()) != 0)) {
+            std::cerr << "Error: unable to replace the segment [" << path(id, ".data") << "]\n";
+            std::exit(EXIT_FAILURE);
+        }
+
+        Segment* segment = openSegment(id, false);
+        if (segment == nullptr) {
+            std::cerr << "Error: unable to open the segment [" << path(id, ".data") << "]\n";
+            std::exit(EXIT_FAILURE);
+        }
+        segment->dead = dead[id];
+        segments_[id] = segment;
+    }
+}
+
+// write the records not expired in compacted segments (temporary files) with their hints
+// the compacted segments take the IDs of the old ones, in the same order
+bool LogEngine::writeCompacted(std::vector<LiveRecord>& records, const std::vector<std::uint32_t>& inputs,
+                               const std::unordered_map<std::uint32_t, int>& fds, std::vector<std::uint32_t>& outputs)
+{
+    std::int64_t now = std::time(nullptr);
+    std::vector<std::uint8_t> data;
+    std::vector<std::uint8_t> hint;
+    std::uint64_t size{0};
+    int fd{-1};
+    bool result{true};
+
+    // write the pending records of the current compacted segment
+    auto flush = [&]() {
+        result = result && writeAll(fd, data.data(), data.size());
+        data.clear();
+    };
+
+    // close the current compacted segment with its hint
+    auto finish = [&]() {
+        if (fd < 0)
+            return;
+
+        flush();
+        result = result && (fdatasync(fd) == 0);
+        close(fd);
+        fd = -1;
+
+        HintHeader header{Constants::Storage::hint_magic, size};
+        memcpy(hint.data(), &header, sizeof(header));
+
+        int hint_fd = open(path(outputs.back(), ".hint.compact").c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        result = result && (hint_fd >= 0) && writeAll(hint_fd, hint.data(), hint.size()) && (fdatasync(hint_fd) == 0);
+        if (hint_fd >= 0) {
+            close(hint_fd);
+        }
+    };
+
+    for (auto& record : records)
+    {
+        if ((record.expiry != 0) && (record.expiry <= now))
+            continue;
+
+        // start a new compacted segment
+        std::uint64_t record_size = sizeof(RecordHeader) + record.key.size() + record.vsize;
+        if ((fd < 0) || ((size > 0) && (size + record_size > Constants::Storage::segment_size)))
+        {
+            finish();
+            if (!result || (outputs.size() == inputs.size())) {
+                result = false;
+                break;
+            }
+
+            outputs.push_back(inputs[outputs.size()]);
+            fd = open(path(outputs.back(), ".data.compact").c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            if (fd < 0) {
+                result = false;
+                break;
+            }
+            size = 0;
+            hint.assign(sizeof(HintHeader), 0);
+        }
+
+        // copy the record with its current expiry
+        std::size_t position = data.size();
+        data.resize(position + record_size);
+        std::uint8_t* pRecord = data.data() + position;
+        if (pread(fds.at(record.segment), pRecord, record_size, record.offset) != static_cast<ssize_t>(record_size)) {
+            result = false;
+            break;
+        }
+
+        RecordHeader header{};
+        memcpy(&header, pRecord, sizeof(header));
+        header.expiry = record.expiry;
+        memcpy(pRecord, &header, sizeof(header));
+        header.crc = crc32(0, pRecord + sizeof(header.crc), record_size - sizeof(header.crc));
+        memcpy(pRecord, &header, sizeof(header));
+
+        HintEntry entry{};
+        entry.uid = record.uid;
+        entry.ksize = record.key.size();
+        entry.vsize = record.vsize;
+        entry.expiry = record.expiry;
+        entry.offset = size;
+        hint.insert(hint.end(), reinterpret_cast<std::uint8_t*>(&entry), reinterpret_cast<std::uint8_t*>(&entry) + sizeof(entry));
+        hint.insert(hint.end(), record.key.begin(), record.key.end());
+
+        record.target = outputs.back();
+        record.target_offset = size;
+        size += record_size;
+
+        if (data.size() >= Constants::Storage::compaction_buffer) {
+            flush();
+        }
+    }
+
+    finish();
+
+    if (!result) {
+        std::cerr << "Error: unable to compact the segments of [" << directory_ << "]\n";
+        if (fd >= 0) {
+            close(fd);
+        }
+        for (auto id : outputs) {
+            unlink(path(id, ".data.compact").c_str());
+            unlink(path(id, ".hint.compact").c_str());
+        }
+    }
+
+    return result;
+}
+
+}   //< end namespace
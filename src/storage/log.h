@@ -0,0 +1,183 @@
+/*
+ * @file    log.h
+ * @brief   Header file for the Storage LogEngine class
+ */
+
+// ----- guards
+#ifndef STORAGE_LOG_H
+#define STORAGE_LOG_H
+
+// ----- includes
+#include "engine.h"
+#include "ordered.h"
+#include "wheel.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+
+// ----- class
+namespace Storage
+{
+    // log-structured engine: the records are appended to segment files and
+    // an in-memory hash index gives the location of the latest value of each key
+    // a write is a single append, a read a single pread
+    // an ordered index of the keys serves the scans
+    // the dead records of the old segments are dropped by a background compaction,
+    // which also writes a hint file per segment to rebuild the index quickly
+    class LogEngine : public Engine
+    {
+    public:     //< public methods
+        LogEngine(std::string directory);
+        virtual ~LogEngine();
+
+        // no copy semantics
+        LogEngine(const LogEngine&) = delete;
+        LogEngine& operator=(const LogEngine&) = delete;
+
+        // no move semantics
+        LogEngine(LogEngine&&) = delete;
+        LogEngine& operator=(LogEngine&&) = delete;
+
+        DBResult* get(const std::uint8_t* key, int ksize, int uid) override;
+        bool set(const std::uint8_t* key, int ksize, const std::uint8_t* value, int vsize, int uid) override;
+        bool exists(const std::uint8_t* key, int ksize, int uid) override;
+        bool remove(const std::uint8_t* key, int ksize, int uid) override;
+        void getMany(const Key* keys, int count, DBResult** results) override;
+        DBResult* getForUpdate(const std::uint8_t* key, int ksize, int uid) override;
+        bool expire(const std::uint8_t* key, int ksize, int uid, std::int64_t deadline) override;
+        void scan(const std::uint8_t* prefix, int psize, int uid, ScanCallback callback) override;
+        void list(const std::uint8_t* after, int asize, int uid, ScanCallback callback) override;
+        int purge(std::int64_t now, int limit, PurgeCallback callback) override;
+
+        void begin() override;
+        bool commit() override;
+
+    private:    //< private types
+        enum Record_t : std::uint8_t {
+            R_PUT = 1,                  //< key and value
+            R_DELETE,                   //< tombstone, key only
+            R_EXPIRE,                   //< new expiry of the key, key only
+        };
+
+        // header of a record in a segment, followed by the key and the value
+        // the checksum covers everything after it
+        struct RecordHeader
+        {
+            std::uint32_t crc;
+            std::uint8_t type;
+            std::uint8_t reserved[3];
+            std::int32_t uid;
+            std::uint32_t ksize;
+            std::uint32_t vsize;
+            std::int64_t expiry;        //< 0: no expiry
+        };
+
+        // entry of a hint file, followed by the key
+        struct HintEntry
+        {
+            std::int32_t uid;
+            std::uint32_t ksize;
+            std::uint32_t vsize;
+            std::uint32_t reserved;
+            std::int64_t expiry;
+            std::uint64_t offset;       //< of the record in the segment
+        };
+
+        // a hint file is only used if the segment has the size recorded
+        struct HintHeader
+        {
+            std::uint64_t magic;
+            std::uint64_t size;         //< of the segment described
+        };
+
+        struct Segment
+        {
+            std::uint32_t id;
+            int fd;
+            std::uint64_t size;         //< bytes written
+            std::uint64_t dead;         //< bytes of the records replaced or deleted
+        };
+
+        // latest record of a key, the key of the index points to the key copy
+        struct Location
+        {
+            std::uint32_t segment;
+            std::uint64_t offset;
+            int ksize;
+            int vsize;
+            std::int64_t expiry;
+            std::uint8_t* pKey;
+
+            ~Location() {
+                delete [] pKey;
+            }
+        };
+
+        // a record copied by the compaction (the index may change meanwhile)
+        struct LiveRecord
+        {
+            int uid;
+            std::string key;
+            std::uint32_t segment;
+            std::uint64_t offset;
+            int vsize;
+            std::int64_t expiry;
+            std::uint32_t target;       //< compacted segment, 0 if the record has expired
+            std::uint64_t target_offset;
+        };
+
+        using Index = std::unordered_map<Key, Location*, KeyHash>;
+
+    private:    //< private methods
+        std::string path(std::uint32_t id, const char* extension) const;
+        Segment* openSegment(std::uint32_t id, bool create);
+        void loadSegments();                        //< rebuild the index at startup
+        bool loadHint(Segment* segment);
+        void loadRecords(Segment* segment);
+        void apply(Segment* segment, std::uint64_t offset, const RecordHeader& header, const std::uint8_t* key);
+
+        // append a record to the active segment, false on error
+        bool append(Record_t type, const std::uint8_t* key, int ksize, const std::uint8_t* value, int vsize,
+                    int uid, std::int64_t expiry, std::uint64_t& offset);
+        void rotate();                              //< start a new active segment
+        Location* find(const std::uint8_t* key, int ksize, int uid);   //< nullptr if missing or expired
+        DBResult* read(const Location* location);                      //< nullptr if location is nullptr
+        void release(Location* location);           //< account the record of a location as dead
+
+        // background compaction of the old segments
+        void compactLoop();
+        bool needsCompaction();
+        void compact();
+        bool writeCompacted(std::vector<LiveRecord>& records, const std::vector<std::uint32_t>& inputs,
+                            const std::unordered_map<std::uint32_t, int>& fds, std::vector<std::uint32_t>& outputs);
+
+    private:    //< private members
+        std::string directory_;
+        std::shared_mutex mutex_;                   //< index and segments (readers shared)
+        std::recursive_mutex writer_;               //< the appends are serialized (held during a batch)
+        Index index_;
+        OrderedIndex<Location> ordered_;            //< the same locations, in the order of the keys
+        std::map<std::uint32_t, Segment*> segments_;
+        Segment* active_;                           //< the only segment written
+        TimingWheel wheel_;                         //< expiries, used by the writer only
+        std::vector<TimingWheel::Timer> expired_;   //< timers due, not purged yet
+
+        // compaction thread
+        std::thread thread_;
+        std::mutex compact_mutex_;
+        std::condition_variable compact_cond_;
+        std::atomic<bool> done_;
+    };
+
+}
+
+#endif // STORAGE_LOG_H
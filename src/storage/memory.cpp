@@ -0,0 +1,248 @@
+/*
+ * @file    memory.cpp
+ * @brief   Source file for the Storage MemoryEngine class
+ */
+
+// ----- includes
+#include "memory.h"
+
+#include <cstring>
+#include <ctime>
+
+
+namespace Storage
+{
+
+// ----- class
+
+// constructor
+MemoryEngine::MemoryEngine() :
+    Engine(), mutex_{}, writer_{}, records_{}, ordered_{}, wheel_{}, expired_{}
+{ }
+
+// destructor
+/*virtual*/ MemoryEngine::~MemoryEngine()
+{
+    ordered_.clear();
+    for (auto& it : records_) {
+        delete it.second;
+    }
+    records_.clear();
+}
+
+// return the record of a key still alive, the table must be locked
+MemoryEngine::Record* MemoryEngine::find(const std::uint8_t* key, int ksize, int uid)
+{
+    Key lookup = makeKey(key, ksize, uid);
+
+    auto it = records_.find(lookup);
+    if (it == records_.end())
+        return nullptr;
+
+    // an expired record is left for the next write of the key
+    Record* record = it->second;
+    if ((record->expiry != 0) && (record->expiry <= std::time(nullptr)))
+        return nullptr;
+
+    return record;
+}
+
+// return a copy of the value
+/*virtual*/ DBResult* MemoryEngine::get(const std::uint8_t* key, int ksize, int uid)
+{
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return copy(find(key, ksize, uid));
+}
+
+// return a copy of the values, all read under the same lock
+/*virtual*/ void MemoryEngine::getMany(const Key* keys, int count, DBResult** results)
+{
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+
+    for (int i = 0; i < count; ++i) {
+        const Key& key = keys[i];
+        results[i] = copy(find(reinterpret_cast<const std::uint8_t*>(key.key.data()), key.key.size(), key.uid));
+    }
+}
+
+// the writes are applied at once: the value is the current one
+/*virtual*/ DBResult* MemoryEngine::getForUpdate(const std::uint8_t* key, int ksize, int uid)
+{
+    return get(key, ksize, uid);
+}
+
+// copy the value of a record, the table must be locked
+DBResult* MemoryEngine::copy(const Record* record)
+{
+    if (record == nullptr)
+        return nullptr;
+
+    DBResult* result = new DBResult{
+        size: record->vsize,
+        pData: new std::uint8_t[record->vsize],
+        expiry: record->expiry
+    };
+    memcpy(result->pData, record->pData + record->ksize, record->vsize);
+
+    return result;
+}
+
+// add a key/value (or replace the value of the key)
+/*virtual*/ bool MemoryEngine::set(const std::uint8_t* key, int ksize, const std::uint8_t* value, int vsize, int uid)
+{
+    // the copy is made before taking the lock
+    Record* record = new Record{
+        ksize: ksize,
+        vsize: vsize,
+        expiry: 0,
+        pData: new std::uint8_t[ksize + vsize]
+    };
+    memcpy(record->pData, key, ksize);
+    memcpy(record->pData + ksize, value, vsize);
+
+    Key owned = makeKey(record->pData, ksize, uid);
+    Record* previous{nullptr};
+    {
+        std::lock_guard<std::recursive_mutex> writer(writer_);
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+
+        // the key of the map points to the data of the record: replace both
+        auto it = records_.find(owned);
+        if (it != records_.end()) {
+            previous = it->second;
+            records_.erase(it);
+        }
+        records_.emplace(owned, record);
+        ordered_.insert(uid, owned.key, record);
+    }
+
+    delete previous;
+    return true;
+}
+
+// check if a key exists
+/*virtual*/ bool MemoryEngine::exists(const std::uint8_t* key, int ksize, int uid)
+{
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return (find(key, ksize, uid) != nullptr);
+}
+
+// delete a key
+/*virtual*/ bool MemoryEngine::remove(const std::uint8_t* key, int ksize, int uid)
+{
+    Key lookup = makeKey(key, ksize, uid);
+    Record* record{nullptr};
+    bool alive{false};
+    {
+        std::lock_guard<std::recursive_mutex> writer(writer_);
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+
+        alive = (find(key, ksize, uid) != nullptr);
+        auto it = records_.find(lookup);
+        if (it != records_.end()) {
+            record = it->second;
+            records_.erase(it);
+            ordered_.erase(uid, lookup.key);
+        }
+    }
+
+    delete record;
+    return alive;
+}
+
+// set the expiry of a key
+/*virtual*/ bool MemoryEngine::expire(const std::uint8_t* key, int ksize, int uid, std::int64_t deadline)
+{
+    std::lock_guard<std::recursive_mutex> writer(writer_);
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+
+    Record* record = find(key, ksize, uid);
+    if (record == nullptr)
+        return false;
+
+    record->expiry = deadline;
+    if (deadline != 0) {
+        wheel_.schedule(uid, key, ksize, deadline);
+    }
+    return true;
+}
+
+// list the keys of a user starting with the prefix
+// the range of the prefix is walked in the ordered index
+/*virtual*/ void MemoryEngine::scan(const std::uint8_t* prefix, int psize, int uid, ScanCallback callback)
+{
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    std::int64_t now = std::time(nullptr);
+    std::string_view start(reinterpret_cast<const char*>(prefix), psize);
+
+    ordered_.visit(uid, start, false, [&](std::string_view key, Record* record) {
+        if (key.substr(0, start.size()) != start)
+            return false;
+
+        if ((record->expiry != 0) && (record->expiry <= now))
+            return true;
+
+        return callback(record->pData, record->ksize);
+    });
+}
+
+// list the keys of a user in order, after a key
+/*virtual*/ void MemoryEngine::list(const std::uint8_t* after, int asize, int uid, ScanCallback callback)
+{
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    std::int64_t now = std::time(nullptr);
+    std::string_view start(reinterpret_cast<const char*>(after), (after != nullptr) ? asize : 0);
+
+    ordered_.visit(uid, start, (after != nullptr), [&](std::string_view, Record* record) {
+        if ((record->expiry != 0) && (record->expiry <= now))
+            return true;
+
+        return callback(record->pData, record->ksize);
+    });
+}
+
+// delete the keys whose timer is due (and still expired)
+/*virtual*/ int MemoryEngine::purge(std::int64_t now, int limit, PurgeCallback callback)
+{
+    std::lock_guard<std::recursive_mutex> writer(writer_);
+    int count{0};
+
+    wheel_.advance(now, expired_);
+    while (!expired_.empty() && (count < limit))
+    {
+        TimingWheel::Timer timer = std::move(expired_.back());
+        expired_.pop_back();
+
+        Record* record{nullptr};
+        {
+            std::unique_lock<std::shared_mutex> lock(mutex_);
+            auto it = records_.find(Key{timer.uid, timer.key});
+            if ((it == records_.end()) || (it->second->expiry == 0) || (it->second->expiry > now))
+                continue;
+
+            record = it->second;
+            records_.erase(it);
+            ordered_.erase(timer.uid, timer.key);
+        }
+
+        callback(timer.uid, record->pData, record->ksize);
+        delete record;
+        count++;
+    }
+
+    return count;
+}
+
+// the writes are applied at once, a batch only keeps the other writers out
+/*virtual*/ void MemoryEngine::begin()
+{
+    writer_.lock();
+}
+
+/*virtual*/ bool MemoryEngine::commit()
+{
+    writer_.unlock();
+    return true;
+}
+
+}   //< end namespace
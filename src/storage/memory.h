@@ -0,0 +1,87 @@
+/*
+ * @file    memory.h
+ * @brief   Header file for the Storage MemoryEngine class
+ */
+
+// ----- guards
+#ifndef STORAGE_MEMORY_H
+#define STORAGE_MEMORY_H
+
+// ----- includes
+#include "engine.h"
+#include "ordered.h"
+#include "wheel.h"
+
+#include <cstddef>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+
+// ----- class
+namespace Storage
+{
+    // engine keeping everything in a hash table, nothing survives the process
+    // an ordered index of the keys serves the scans
+    // the writes are visible at once and can't be rolled back
+    class MemoryEngine : public Engine
+    {
+    public:     //< public methods
+        MemoryEngine();
+        virtual ~MemoryEngine();
+
+        // no copy semantics
+        MemoryEngine(const MemoryEngine&) = delete;
+        MemoryEngine& operator=(const MemoryEngine&) = delete;
+
+        // no move semantics
+        MemoryEngine(MemoryEngine&&) = delete;
+        MemoryEngine& operator=(MemoryEngine&&) = delete;
+
+        DBResult* get(const std::uint8_t* key, int ksize, int uid) override;
+        bool set(const std::uint8_t* key, int ksize, const std::uint8_t* value, int vsize, int uid) override;
+        bool exists(const std::uint8_t* key, int ksize, int uid) override;
+        bool remove(const std::uint8_t* key, int ksize, int uid) override;
+        void getMany(const Key* keys, int count, DBResult** results) override;
+        DBResult* getForUpdate(const std::uint8_t* key, int ksize, int uid) override;
+        bool expire(const std::uint8_t* key, int ksize, int uid, std::int64_t deadline) override;
+        void scan(const std::uint8_t* prefix, int psize, int uid, ScanCallback callback) override;
+        void list(const std::uint8_t* after, int asize, int uid, ScanCallback callback) override;
+        int purge(std::int64_t now, int limit, PurgeCallback callback) override;
+
+        void begin() override;
+        bool commit() override;
+
+    private:    //< private types
+        // the key and the value are stored in a single block, the key of the map points to it
+        struct Record
+        {
+            int ksize;
+            int vsize;
+            std::int64_t expiry;        //< 0: no expiry
+            std::uint8_t* pData;
+
+            ~Record() {
+                delete [] pData;
+            }
+        };
+
+        using Records = std::unordered_map<Key, Record*, KeyHash>;
+
+    private:    //< private methods
+        Record* find(const std::uint8_t* key, int ksize, int uid);     //< nullptr if missing or expired
+        DBResult* copy(const Record* record);                          //< nullptr if record is nullptr
+
+    private:    //< private members
+        std::shared_mutex mutex_;       //< the readers share the table
+        std::recursive_mutex writer_;   //< held by the writer during a batch
+        Records records_;
+        OrderedIndex<Record> ordered_;  //< the same records, in the order of the keys
+        TimingWheel wheel_;             //< expiries, used by the writer only
+        std::vector<TimingWheel::Timer> expired_;   //< timers due, not purged yet
+    };
+
+}
+
+#endif // STORAGE_MEMORY_H
@@ -0,0 +1,102 @@
+/*
+ * @file    ordered.h
+ * @brief   Header file for the Storage OrderedIndex class
+ */
+
+// ----- guards
+#ifndef STORAGE_ORDERED_H
+#define STORAGE_ORDERED_H
+
+// ----- includes
+#include <functional>
+#include <map>
+#include <string_view>
+#include <unordered_map>
+
+
+// ----- class
+namespace Storage
+{
+    // keys of each user in order, next to the hash index of an engine
+    // a range of keys is found in O(log n) and walked in order (scans and listings)
+    // the index references the keys and the entries: they belong to the engine
+    // the index is not thread-safe
+    template <typename T>
+    class OrderedIndex
+    {
+    public:     //< public types
+        // called for each key visited, false to stop
+        using Visitor = std::function<bool(std::string_view key, T* entry)>;
+
+    public:     //< public methods
+        OrderedIndex() = default;
+        ~OrderedIndex() = default;
+
+        // no copy semantics
+        OrderedIndex(const OrderedIndex&) = delete;
+        OrderedIndex& operator=(const OrderedIndex&) = delete;
+
+        // no move semantics
+        OrderedIndex(OrderedIndex&&) = delete;
+        OrderedIndex& operator=(OrderedIndex&&) = delete;
+
+        // add a key, or point it to a new entry (and its copy of the key)
+        void insert(int uid, std::string_view key, T* entry)
+        {
+            Keys& keys = users_[uid];
+            auto it = keys.find(key);
+            if (it == keys.end()) {
+                keys.emplace(key, entry);
+                return;
+            }
+
+            // the node is reused, only the view of the key changes
+            auto node = keys.extract(it);
+            node.key() = key;
+            node.mapped() = entry;
+            keys.insert(std::move(node));
+        }
+
+        void erase(int uid, std::string_view key)
+        {
+            auto user = users_.find(uid);
+            if (user == users_.end())
+                return;
+
+            user->second.erase(key);
+            if (user->second.empty()) {
+                users_.erase(user);
+            }
+        }
+
+        void clear()
+        {
+            users_.clear();
+        }
+
+        // visit the keys of a user in order, from the first one not before start
+        // (after start if exclusive) until the visitor returns false
+        void visit(int uid, std::string_view start, bool exclusive, const Visitor& visitor) const
+        {
+            auto user = users_.find(uid);
+            if (user == users_.end())
+                return;
+
+            const Keys& keys = user->second;
+            auto it = exclusive ? keys.upper_bound(start) : keys.lower_bound(start);
+            for (; it != keys.end(); ++it) {
+                if (!visitor(it->first, it->second))
+                    break;
+            }
+        }
+
+    private:    //< private types
+        using Keys = std::map<std::string_view, T*>;
+
+    private:    //< private members
+        std::unordered_map<int, Keys> users_;
+    };
+
+}
+
+#endif // STORAGE_ORDERED_H
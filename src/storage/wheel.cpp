@@ -0,0 +1,107 @@
+/*
+ * @file    wheel.cpp
+ * @brief   Source file for the Storage TimingWheel class
+ */
+
+// ----- includes
+#include "wheel.h"
+
+#include <ctime>
+#include <utility>
+
+
+namespace Storage
+{
+
+// ----- class
+
+// constructor
+TimingWheel::TimingWheel() :
+    wheel_{}, overflow_{}, ready_{}, current_{std::time(nullptr)}
+{ }
+
+// add the timer of a key
+void TimingWheel::schedule(int uid, const std::uint8_t* key, int ksize, std::int64_t deadline)
+{
+    place(Timer{uid, std::string(reinterpret_cast<const char*>(key), ksize), deadline});
+}
+
+// put a timer in the slot of the lowest level covering its deadline
+void TimingWheel::place(Timer&& timer)
+{
+    std::int64_t delta = timer.deadline - current_;
+
+    if (delta <= 0) {
+        ready_.push_back(std::move(timer));
+        return;
+    }
+
+    for (int level = 0; level < levels; ++level) {
+        if (delta < (std::int64_t{1} << (bits * (level + 1)))) {
+            int slot = (timer.deadline >> (bits * level)) & (slots - 1);
+            wheel_[level][slot].push_back(std::move(timer));
+            return;
+        }
+    }
+
+    overflow_.push_back(std::move(timer));
+}
+
+// the timers of a slot get closer to their deadline: move them down
+void TimingWheel::cascade(int level)
+{
+    if (level == levels) {
+        std::vector<Timer> timers;
+        timers.swap(overflow_);
+        for (auto& timer : timers) {
+            place(std::move(timer));
+        }
+        return;
+    }
+
+    int slot = (current_ >> (bits * level)) & (slots - 1);
+    std::vector<Timer> timers;
+    timers.swap(wheel_[level][slot]);
+
+    // the upper level wraps at the same time
+    if (slot == 0) {
+        cascade(level + 1);
+    }
+
+    for (auto& timer : timers) {
+        place(std::move(timer));
+    }
+}
+
+// tick until now and collect the timers due
+void TimingWheel::advance(std::int64_t now, std::vector<Timer>& due)
+{
+    for (auto& timer : ready_) {
+        due.push_back(std::move(timer));
+    }
+    ready_.clear();
+
+    while (current_ < now)
+    {
+        current_++;
+
+        // the first slot of a level: refill the lower levels
+        int slot = current_ & (slots - 1);
+        if (slot == 0) {
+            cascade(1);
+        }
+
+        for (auto& timer : wheel_[0][slot]) {
+            due.push_back(std::move(timer));
+        }
+        wheel_[0][slot].clear();
+
+        // the timers cascaded at this tick may be due already
+        for (auto& timer : ready_) {
+            due.push_back(std::move(timer));
+        }
+        ready_.clear();
+    }
+}
+
+}   //< end namespace
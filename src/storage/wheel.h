@@ -0,0 +1,66 @@
+/*
+ * @file    wheel.h
+ * @brief   Header file for the Storage TimingWheel class
+ */
+
+// ----- guards
+#ifndef STORAGE_WHEEL_H
+#define STORAGE_WHEEL_H
+
+// ----- includes
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+// ----- class
+namespace Storage
+{
+    // hierarchical timing wheel of the key expiries, one second per tick
+    // scheduling a key and collecting the keys due are O(1), whatever the
+    // number of keys (each key is moved at most once per level)
+    // the wheel is not thread-safe
+    class TimingWheel
+    {
+    public:     //< public types
+        struct Timer
+        {
+            int uid;
+            std::string key;
+            std::int64_t deadline;
+        };
+
+    public:     //< public methods
+        TimingWheel();
+
+        // no copy semantics
+        TimingWheel(const TimingWheel&) = delete;
+        TimingWheel& operator=(const TimingWheel&) = delete;
+
+        // no move semantics
+        TimingWheel(TimingWheel&&) = delete;
+        TimingWheel& operator=(TimingWheel&&) = delete;
+
+        // the key may have changed before its timer is due: check it again
+        void schedule(int uid, const std::uint8_t* key, int ksize, std::int64_t deadline);
+        void advance(std::int64_t now, std::vector<Timer>& due);    //< add the timers due at now
+
+    private:    //< private types
+        static constexpr int levels{4};
+        static constexpr int bits{6};
+        static constexpr int slots{1 << bits};      //< level N covers 64^(N+1) seconds
+
+    private:    //< private methods
+        void place(Timer&& timer);
+        void cascade(int level);                    //< move the timers of a slot to the lower levels
+
+    private:    //< private members
+        std::vector<Timer> wheel_[levels][slots];
+        std::vector<Timer> overflow_;               //< beyond the last level (~6 months)
+        std::vector<Timer> ready_;                  //< already due when scheduled
+        std::int64_t current_;                      //< time of the last tick
+    };
+
+}
+
+#endif // STORAGE_WHEEL_H
@@ -0,0 +1,153 @@
+/*
+ * @file    arena.cpp
+ * @brief   Source file for the VM Arena class
+ */
+
+// ----- includes
+#include "../constants.h"
+#include "arena.h"
+
+#include <vector>
+
+
+namespace VM
+{
+
+// ----- cache
+
+namespace
+{
+    // arenas released by a thread, reused by its next requests
+    struct Cache
+    {
+        std::vector<Arena*> arenas;
+
+        ~Cache() {
+            for (auto* arena : arenas) {
+                delete arena;
+            }
+        }
+    };
+
+    thread_local Cache cache;
+}
+
+
+// ----- class
+
+// constructor
+Arena::Arena() :
+    blocks_{nullptr}, large_{nullptr}, adopted_{nullptr}, ptr_{nullptr}, end_{nullptr}
+{ }
+
+// destructor
+Arena::~Arena()
+{
+    freeAdopted();
+    freeBlocks(blocks_);
+    freeBlocks(large_);
+}
+
+// allocate a memory block, its data follows the header
+Arena::Block* Arena::newBlock(std::size_t size)
+{
+    std::uint8_t* memory = new std::uint8_t[sizeof(Block) + size];
+    return new (memory) Block{nullptr, size};
+}
+
+// release a list of blocks
+void Arena::freeBlocks(Block* block)
+{
+    while (block != nullptr) {
+        Block* next = block->next;
+        delete [] reinterpret_cast<std::uint8_t*>(block);
+        block = next;
+    }
+}
+
+// release the external blocks
+void Arena::freeAdopted()
+{
+    for (Adopted* adopted = adopted_; adopted != nullptr; adopted = adopted->next) {
+        delete [] adopted->pData;
+    }
+    adopted_ = nullptr;
+}
+
+// return n bytes aligned on align (a power of 2)
+void* Arena::allocate(std::size_t n, std::size_t align)
+{
+    std::size_t block_size = Constants::VM::arena_block_size;
+
+    // large allocations get their own block, the current one is kept
+    if (n > block_size / 2) {
+        Block* block = newBlock(n);
+        block->next = large_;
+        large_ = block;
+        return block + 1;
+    }
+
+    std::uintptr_t ptr = (reinterpret_cast<std::uintptr_t>(ptr_) + align - 1) & ~(align - 1);
+    if ((ptr_ == nullptr) || (ptr + n > reinterpret_cast<std::uintptr_t>(end_))) {
+        Block* block = newBlock(block_size);
+        block->next = blocks_;
+        blocks_ = block;
+
+        ptr_ = reinterpret_cast<std::uint8_t*>(block + 1);
+        end_ = ptr_ + block_size;
+        ptr = (reinterpret_cast<std::uintptr_t>(ptr_) + align - 1) & ~(align - 1);
+    }
+
+    ptr_ = reinterpret_cast<std::uint8_t*>(ptr + n);
+    return reinterpret_cast<void*>(ptr);
+}
+
+// the block will be released with the arena
+void Arena::adopt(std::uint8_t* pData)
+{
+    adopted_ = create<Adopted>(adopted_, pData);
+}
+
+// release everything but the current block
+void Arena::reset()
+{
+    freeAdopted();
+    freeBlocks(large_);
+    large_ = nullptr;
+
+    if (blocks_ != nullptr) {
+        freeBlocks(blocks_->next);
+        blocks_->next = nullptr;
+
+        ptr_ = reinterpret_cast<std::uint8_t*>(blocks_ + 1);
+        end_ = ptr_ + blocks_->size;
+    }
+}
+
+// take an arena from the cache of the thread (or create a new one)
+/*static*/ Arena* Arena::acquire()
+{
+    if (cache.arenas.empty())
+        return new Arena();
+
+    Arena* arena = cache.arenas.back();
+    cache.arenas.pop_back();
+    return arena;
+}
+
+// give back an arena to the cache of the thread
+/*static*/ void Arena::release(Arena* arena)
+{
+    if (arena == nullptr)
+        return;
+
+    if (cache.arenas.size() >= Constants::VM::arena_cache) {
+        delete arena;
+        return;
+    }
+
+    arena->reset();
+    cache.arenas.push_back(arena);
+}
+
+} //< end of namespace
@@ -0,0 +1,81 @@
+/*
+ * @file    arena.h
+ * @brief   Header file for the VM Arena class
+ */
+
+// ----- guards
+#ifndef VM_ARENA_H
+#define VM_ARENA_H
+
+// ----- includes
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+
+
+// ----- class
+namespace VM
+{
+    // bump allocator holding all the memory of a request: items, payloads and response
+    // nothing is released individually, the whole arena is reset once the response is sent
+    class Arena
+    {
+    public:     //< public methods
+        Arena();
+        ~Arena();
+
+        // no copy semantics
+        Arena(const Arena&) = delete;
+        Arena& operator=(const Arena&) = delete;
+
+        // no move semantics
+        Arena(Arena&&) = delete;
+        Arena& operator=(Arena&&) = delete;
+
+        void* allocate(std::size_t n, std::size_t align = alignof(std::max_align_t));
+        void adopt(std::uint8_t* pData);    //< take ownership of a block allocated with new[]
+        void reset();                       //< release all the allocations at once
+
+        // construct an object in the arena (its destructor is never called)
+        template <typename T, typename... Args>
+        T* create(Args&&... args)
+        {
+            return new (allocate(sizeof(T), alignof(T))) T{std::forward<Args>(args)...};
+        }
+
+        // arenas recycled by the current thread
+        static Arena* acquire();
+        static void release(Arena* arena);
+
+    private:    //< private types
+        // header of a memory block, followed by the data
+        struct Block
+        {
+            Block* next;
+            std::size_t size;
+        };
+
+        // external block released with the arena
+        struct Adopted
+        {
+            Adopted* next;
+            std::uint8_t* pData;
+        };
+
+    private:    //< private methods
+        Block* newBlock(std::size_t size);
+        void freeBlocks(Block* block);
+        void freeAdopted();
+
+    private:    //< private members
+        Block* blocks_;                 //< regular blocks, the current one first
+        Block* large_;                  //< dedicated blocks of the large allocations
+        Adopted* adopted_;              //< external blocks (the nodes live in the arena)
+        std::uint8_t* ptr_;             //< next free byte in the current block
+        std::uint8_t* end_;             //< end of the current block
+    };
+
+} //< end of namespace
+
+#endif // VM_ARENA_H
@@ -9,8 +9,8 @@
 
 
 // ----- includes
+#include <cstddef>
 #include <cstdint>
-#include <queue>
 
 
 // ----- definitions
@@ -30,7 +30,7 @@ enum class Opcodes_t {
 
     OP_DEL,                //< "DELETE KEY"
 
-    OP_PRT,                //< "PRINT 'regexp'"
+    OP_PRT,                //< "PRINT 'regexp'", the pattern is sent as the key
 
     OP_EXIST,              //< "EXIST KEY"
 
@@ -46,22 +46,102 @@ enum class Opcodes_t {
 
     // ----- USER
     U_USER,                 //< User ID
+
+    // ----- PIPELINING
+    I_ID,                   //< Request ID, first block of the frame (the response may come out of order)
+
+    // ----- OPERATORS (added later, the values above are part of the protocol)
+    OP_SCAN,               //< "SCAN CURSOR [COUNT]", the cursor is sent as the key
+
+    // several keys in a frame, the keys (and values) are entries of the value (see VM::readEntry())
+    // the response is an entry per key: the result code (R_VALUE or R_ERROR) then the entry
+    OP_MGET,               //< "MGET KEY..."
+    OP_MSET,               //< "MSET KEY VALUE..."
+    OP_MDEL,               //< "MDEL KEY..."
+
+    // read-modify-write of a key by the writer, nothing can change the key meanwhile
+    OP_INCR,               //< "INCRBY KEY DELTA", the value is a decimal integer (0 if missing)
+    OP_DECR,               //< "DECRBY KEY DELTA"
+    OP_APPEND,             //< "APPEND KEY VALUE", the response is the new size
+    OP_CAS,                //< "CAS KEY [EXPECTED] VALUE", entries of the value (no EXPECTED: the key must not exist)
 };
 
 // queue item
+// the item and its data are allocated in the arena of the request
 struct QueueItem
 {
     Opcodes_t opcode;               //< the opcode
-    std::uint16_t szdata;           //< size of the following data (max 64KiB)
+    std::uint32_t szdata;           //< size of the following data (max 64KiB in a v1 frame)
     std::uint8_t* pdata;            //< pointer to the data
+    QueueItem* next;                //< next item in the queue
+};
 
-    ~QueueItem() {
-        delete [] pdata;
+// queue of items linked together, the queue doesn't own them
+class ItemQueue
+{
+public:
+    void push(QueueItem* item) {
+        item->next = nullptr;
+        if (tail_) {
+            tail_->next = item;
+        } else {
+            head_ = item;
+        }
+        tail_ = item;
+        size_++;
+    }
+
+    void pop() {
+        head_ = head_->next;
+        if (head_ == nullptr) {
+            tail_ = nullptr;
+        }
+        size_--;
     }
+
+    QueueItem* front() const { return head_; }
+    bool empty() const { return head_ == nullptr; }
+    std::size_t size() const { return size_; }
+
+private:
+    QueueItem* head_{nullptr};
+    QueueItem* tail_{nullptr};
+    std::size_t size_{0};
+};
+
+// view over the data of a block (or of several blocks gathered in the arena)
+struct Span
+{
+    const std::uint8_t* data;       //< first byte (nullptr if empty)
+    std::size_t size;               //< number of bytes
+};
+
+// header of a v2 frame, followed by the key then the value
+// all the fields are in host byte order, as the sizes of the v1 blocks
+struct FrameHeader
+{
+    std::uint8_t magic;             //< Constants::Network::Protocol::magic
+    std::uint8_t version;           //< Constants::Network::Protocol::version
+    std::uint8_t opcode;            //< command (request) or result code (response)
+    std::uint8_t flags;             //< FrameFlags_t
+    std::uint32_t key_length;       //< size of the key
+    std::uint64_t total_length;     //< size of the payload (key + value)
+    std::uint64_t value_length;     //< size of the value
+    std::uint64_t id;               //< request ID (if F_ID is set)
+    std::int32_t uid;               //< user ID
+    std::uint32_t reserved;         //< must be 0
+};
+
+static_assert(sizeof(FrameHeader) == 40, "the v2 frame header must be 40 bytes");
+
+// flags of a v2 frame
+enum FrameFlags_t : std::uint8_t {
+    F_ID = 0x01,                    //< the frame carries a request ID
+    F_MORE = 0x02,                  //< response: more frames follow for the same request
 };
 
 // typedef
-using queue_t = std::queue<QueueItem*>;
+using queue_t = ItemQueue;
 
 } //< end of namespace
 
@@ -22,23 +22,71 @@ int getUID(QueueItem* item)
         return -1;
     }
 
+    if (item->szdata < sizeof(int)) {
+        std::cerr << "Error: U_USER block is too small in VM::getUID!\n";
+        return -1;
+    }
+
     // cast the pointer to an int
     int* p = reinterpret_cast<int*>(item->pdata);
     return *p;
 }
 
-// retrieve the data from a block
-std::uint8_t* getData(QueueItem* item, std::uint16_t* size)
+// allocate a block in the arena
+QueueItem* createItem(Arena* arena, Opcodes_t opcode, std::uint32_t size)
+{
+    QueueItem* item = arena->create<QueueItem>();
+    item->opcode = opcode;
+    item->szdata = size;
+
+    if (size > 0) {
+        item->pdata = static_cast<std::uint8_t*>(arena->allocate(size + 1, 1));
+        item->pdata[size] = 0;
+    }
+
+    return item;
+}
+
+// allocate a block in the arena and copy the data
+QueueItem* createItem(Arena* arena, Opcodes_t opcode, const void* pData, std::uint32_t size)
+{
+    QueueItem* item = createItem(arena, opcode, size);
+    if (size > 0) {
+        memcpy(item->pdata, pData, size);
+    }
+
+    return item;
+}
+
+// allocate a block in the arena with the data as an entry
+QueueItem* createEntry(Arena* arena, Opcodes_t opcode, const void* pData, std::uint32_t size)
+{
+    QueueItem* item = createItem(arena, opcode, sizeof(size) + size);
+    memcpy(item->pdata, &size, sizeof(size));
+    if (size > 0) {
+        memcpy(item->pdata + sizeof(size), pData, size);
+    }
+
+    return item;
+}
+
+// read the entry at the start of the payload
+bool readEntry(Span& payload, Span& entry)
 {
-    // return the size to the caller
-    *size = item->szdata;
+    std::uint32_t size{0};
+    if (payload.size < sizeof(size))
+        return false;
+
+    memcpy(&size, payload.data, sizeof(size));
+    if (payload.size - sizeof(size) < size)
+        return false;
 
-    // copy the data to a different block in memory
-    std::uint8_t* dest = new std::uint8_t[item->szdata + 1];
-    memset(dest, 0, item->szdata + 1);
-    memcpy(dest, item->pdata, item->szdata);
+    entry.data = payload.data + sizeof(size);
+    entry.size = size;
+    payload.data += sizeof(size) + size;
+    payload.size -= sizeof(size) + size;
 
-    return dest;
+    return true;
 }
 
 } //< end of namespace
@@ -7,6 +7,7 @@
 #define VM_HELPERS_H
 
 // ----- include
+#include "arena.h"
 #include "defines.h"
 
 #include <cstdint>
@@ -20,8 +21,18 @@ namespace VM
 // retrieve the UID from the U_USER block
 int getUID(QueueItem* item);
 
-// retrieve the data from a block
-std::uint8_t* getData(QueueItem* item, std::uint16_t* size);
+// allocate a block in the arena, the data is followed by a '\0' for the string conversions
+QueueItem* createItem(Arena* arena, Opcodes_t opcode, std::uint32_t size);
+
+// allocate a block in the arena and copy the data
+QueueItem* createItem(Arena* arena, Opcodes_t opcode, const void* pData, std::uint32_t size);
+
+// allocate a block in the arena with the data as an entry: its size (32 bits, host byte order) then the data
+QueueItem* createEntry(Arena* arena, Opcodes_t opcode, const void* pData, std::uint32_t size);
+
+// read the entry at the start of the payload, the payload is moved after it
+// return false if the payload is truncated
+bool readEntry(Span& payload, Span& entry);
 
 // // retrieve the key from the K_NAME block
 // std::uint8_t* getKey(QueueItem* item, std::uint16_t* size);
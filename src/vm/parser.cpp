@@ -0,0 +1,309 @@
+/*
+ * @file    parser.cpp
+ * @brief   Source file for the frame Parser class
+ */
+
+// ----- includes
+#include "../constants.h"
+#include "helpers.h"
+#include "parser.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+
+namespace VM
+{
+
+// ----- class
+
+// constructor
+Parser::Parser() :
+    state_{State_t::SOT}, version_{0}, header_{}, opcode_{Opcodes_t::R_ERROR}, size_{0}, count_{0},
+    item_{nullptr}, next_{nullptr}, id_{nullptr}, arena_{nullptr}
+{ }
+
+// destructor
+Parser::~Parser()
+{
+    Arena::release(arena_);
+}
+
+// forget the items (if any), their memory is released with the arena
+void Parser::freeItems()
+{
+    item_ = nullptr;
+    next_ = nullptr;
+    id_ = nullptr;
+    items_ = queue_t{};
+
+    if (arena_) {
+        arena_->reset();
+    }
+}
+
+// reset the parser to wait for a new frame
+void Parser::reset()
+{
+    freeItems();
+    state_ = State_t::SOT;
+    version_ = 0;
+    count_ = 0;
+}
+
+// frame has been fully read
+bool Parser::isComplete() const
+{
+    return state_ == State_t::DONE;
+}
+
+// frame is invalid
+bool Parser::isError() const
+{
+    return state_ == State_t::ERROR;
+}
+
+// version of the frame being read
+int Parser::version() const
+{
+    return version_;
+}
+
+// the frame is a part of a streamed response
+bool Parser::hasMore() const
+{
+    return (version_ == Constants::Network::Protocol::version) && (header_.flags & F_MORE);
+}
+
+// opcode of the header, no item carries it when the value is empty
+Opcodes_t Parser::opcode() const
+{
+    if (version_ != Constants::Network::Protocol::version)
+        return Opcodes_t::R_ERROR;
+
+    return static_cast<Opcodes_t>(header_.opcode);
+}
+
+// return the items read so far
+queue_t& Parser::items()
+{
+    return items_;
+}
+
+// take the request ID block (it lives in the arena of the frame)
+QueueItem* Parser::releaseID()
+{
+    QueueItem* id = id_;
+    id_ = nullptr;
+    return id;
+}
+
+// return the memory of the frame, the caller becomes its owner
+// the items and the request ID remain valid until the arena is released
+Arena* Parser::releaseArena()
+{
+    Arena* arena = arena_ ? arena_ : Arena::acquire();
+    arena_ = nullptr;
+    return arena;
+}
+
+// add a complete block to the frame
+void Parser::addItem(QueueItem* item)
+{
+    if (item->opcode == Opcodes_t::I_ID) {
+        id_ = item;
+        return;
+    }
+
+    items_.push(item);
+}
+
+// allocate a block in the memory of the frame
+QueueItem* Parser::newItem(Opcodes_t opcode, std::uint32_t size)
+{
+    if (arena_ == nullptr) {
+        arena_ = Arena::acquire();
+    }
+
+    return createItem(arena_, opcode, size);
+}
+
+// check the header of a v2 frame and prepare its blocks
+// a request is decoded into the same items as a v1 frame:
+// the command, the user, the key and the value
+// a response only carries its result code and the value
+bool Parser::parseHeader()
+{
+    if ((header_.version != Constants::Network::Protocol::version) ||
+        (header_.total_length != header_.key_length + header_.value_length) ||
+        (header_.total_length > Constants::Network::Protocol::max_payload_size)) {
+        return false;
+    }
+
+    Opcodes_t opcode = static_cast<Opcodes_t>(header_.opcode);
+    bool request = (opcode < Opcodes_t::K_NAME) || (opcode >= Opcodes_t::OP_SCAN);
+
+    if (header_.flags & F_ID) {
+        QueueItem* id = newItem(Opcodes_t::I_ID, sizeof(header_.id));
+        memcpy(id->pdata, &header_.id, sizeof(header_.id));
+        addItem(id);
+    }
+
+    if (request) {
+        addItem(newItem(opcode, 0));
+
+        QueueItem* user = newItem(Opcodes_t::U_USER, sizeof(header_.uid));
+        memcpy(user->pdata, &header_.uid, sizeof(header_.uid));
+        addItem(user);
+    }
+
+    // the key then the value are read directly in their block
+    if (header_.key_length > 0) {
+        item_ = newItem(Opcodes_t::K_NAME, header_.key_length);
+    }
+
+    if (header_.value_length > 0) {
+        QueueItem* value = newItem(request ? Opcodes_t::V_VALUE : opcode, header_.value_length);
+        if (item_) {
+            next_ = value;
+        } else {
+            item_ = value;
+        }
+    }
+
+    return true;
+}
+
+// memory still expected by the block being read (nullptr if none)
+// the data can be received there directly rather than through parse()
+std::uint8_t* Parser::pending(std::size_t* size)
+{
+    if (state_ != State_t::DATA) {
+        *size = 0;
+        return nullptr;
+    }
+
+    *size = item_->szdata - count_;
+    return item_->pdata + count_;
+}
+
+// n bytes have been written in the block being read
+void Parser::commit(std::size_t n)
+{
+    count_ += n;
+
+    // block is complete
+    if (count_ == static_cast<int>(item_->szdata)) {
+        addItem(item_);
+        count_ = 0;
+
+        // v2: the value follows the key, the frame has no EOT
+        item_ = next_;
+        next_ = nullptr;
+        if (version_ == 1) {
+            state_ = State_t::OPCODE;
+        } else {
+            state_ = item_ ? State_t::DATA : State_t::DONE;
+        }
+    }
+}
+
+// consume the data and return the number of bytes used
+int Parser::parse(const std::uint8_t* pData, int size)
+{
+    int count{0};
+
+    while ((count < size) && (state_ != State_t::DONE) && (state_ != State_t::ERROR))
+    {
+        switch(state_)
+        {
+            case State_t::SOT:
+                {
+                    if (pData[count] == Constants::Network::Protocol::sot) {
+                        version_ = 1;
+                        state_ = State_t::OPCODE;
+                    } else if (pData[count] == Constants::Network::Protocol::magic) {
+                        version_ = Constants::Network::Protocol::version;
+                        header_.magic = pData[count];
+                        count_ = 1;
+                        state_ = State_t::HEADER;
+                    } else {
+                        state_ = State_t::ERROR;
+                    }
+                    count++;
+                }
+                break;
+
+            case State_t::HEADER:
+                {
+                    // copy as much as possible of the fixed size header
+                    int n = std::min(size - count, static_cast<int>(sizeof(header_)) - count_);
+                    memcpy(reinterpret_cast<std::uint8_t*>(&header_) + count_, pData + count, n);
+                    count_ += n;
+                    count += n;
+
+                    if (count_ < static_cast<int>(sizeof(header_)))
+                        break;
+
+                    count_ = 0;
+                    if (!parseHeader()) {
+                        state_ = State_t::ERROR;
+                    } else {
+                        state_ = item_ ? State_t::DATA : State_t::DONE;
+                    }
+                }
+                break;
+
+            case State_t::OPCODE:
+                {
+                    if (pData[count] == Constants::Network::Protocol::eot) {
+                        state_ = State_t::DONE;
+                    } else {
+                        opcode_ = static_cast<Opcodes_t>(pData[count]);
+                        count_ = 0;
+                        state_ = State_t::SIZE;
+                    }
+                    count++;
+                }
+                break;
+
+            case State_t::SIZE:
+                {
+                    size_[count_++] = pData[count++];
+                    if (count_ < static_cast<int>(sizeof(size_)))
+                        break;
+
+                    std::uint16_t szdata{0};
+                    memcpy(&szdata, size_, sizeof(szdata));
+
+                    if (szdata == 0) {
+                        addItem(newItem(opcode_, 0));
+                        state_ = State_t::OPCODE;
+                    } else {
+                        item_ = newItem(opcode_, szdata);
+                        count_ = 0;
+                        state_ = State_t::DATA;
+                    }
+                }
+                break;
+
+            case State_t::DATA:
+                {
+                    // copy as much as possible from the current block
+                    int n = std::min(size - count, static_cast<int>(item_->szdata) - count_);
+                    memcpy(item_->pdata + count_, pData + count, n);
+                    commit(n);
+                    count += n;
+                }
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    return count;
+}
+
+} //< end of namespace
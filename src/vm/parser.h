@@ -0,0 +1,90 @@
+/*
+ * @file    parser.h
+ * @brief   Header file for the frame Parser class
+ */
+
+// ----- guards
+#ifndef VM_PARSER_H
+#define VM_PARSER_H
+
+// ----- includes
+#include "arena.h"
+#include "defines.h"
+
+#include <cstddef>
+#include <cstdint>
+
+
+// ----- class
+namespace VM
+{
+    // incremental parser turning a frame into a queue of items
+    // the version is detected from the first byte: SOT..EOT blocks (v1)
+    // or a fixed size header followed by the key and the value (v2)
+    // the parser can be fed with partial data and resumes where it stopped
+    class Parser
+    {
+    public:     //< public methods
+        Parser();
+        ~Parser();
+
+        // no copy semantics
+        Parser(const Parser&) = delete;
+        Parser& operator=(const Parser&) = delete;
+
+        // no move semantics
+        Parser(Parser&&) = delete;
+        Parser& operator=(Parser&&) = delete;
+
+        // consume the data and return the number of bytes used
+        int parse(const std::uint8_t* pData, int size);
+
+        // receive the data of the current block in place (no copy)
+        std::uint8_t* pending(std::size_t* size);   //< room left in the block being read
+        void commit(std::size_t n);                 //< n bytes written in this room
+
+        bool isComplete() const;        //< true when the whole frame has been read
+        bool isError() const;           //< true when the frame is invalid
+        int version() const;            //< version of the frame (0 until detected)
+        bool hasMore() const;           //< v2: the response continues in the next frame
+        Opcodes_t opcode() const;       //< v2: opcode of the frame (result code of a response, even without a value)
+
+        queue_t& items();               //< items decoded so far
+        QueueItem* releaseID();         //< take the request ID block of the frame (nullptr if none)
+        Arena* releaseArena();          //< take the memory of the frame (items and request ID)
+        void reset();                   //< prepare the parser for the next frame
+
+    private:    //< private types
+        enum class State_t {
+            SOT,                        //< waiting for the Start-of-Transmission (or the v2 magic)
+            HEADER,                     //< reading the header of a v2 frame
+            OPCODE,                     //< waiting for an opcode or the End-of-Transmission
+            SIZE,                       //< reading the 2 bytes size of the block
+            DATA,                       //< reading the data of the block
+            DONE,                       //< frame is complete
+            ERROR                       //< frame is invalid
+        };
+
+    private:    //< private methods
+        void freeItems();
+        void addItem(QueueItem* item);  //< the request ID is kept aside from the items
+        bool parseHeader();             //< create the items of a v2 frame from its header
+        QueueItem* newItem(Opcodes_t opcode, std::uint32_t size);
+
+    private:    //< private members
+        State_t state_;                 //< current state
+        int version_;                   //< version of the current frame
+        FrameHeader header_;            //< header of the current v2 frame
+        Opcodes_t opcode_;              //< opcode of the current block
+        std::uint8_t size_[2];          //< size of the current block
+        int count_;                     //< number of bytes read in the current state
+        QueueItem* item_;               //< block being read
+        QueueItem* next_;               //< v2: value read after the key
+        queue_t items_;                 //< blocks already read
+        QueueItem* id_;                 //< request ID block
+        Arena* arena_;                  //< memory of the current frame
+    };
+
+} //< end of namespace
+
+#endif // VM_PARSER_H
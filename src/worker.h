@@ -0,0 +1,13 @@
+/*
+ * @file    worker.h
+ * @brief   Aggreggate worker headers
+ */
+
+// ----- guards
+#ifndef WORKER_H
+#define WORKER_H
+
+#include "worker/queue.h"
+#include "worker/pool.h"
+
+#endif // WORKER_H
@@ -0,0 +1,157 @@
+/*
+ * @file    pool.cpp
+ * @brief   Source file for the Worker Pool class
+ */
+
+// ----- includes
+#include "../constants.h"
+#include "pool.h"
+
+#include <atomic>
+#include <chrono>
+
+
+namespace Worker
+{
+
+// ----- class
+
+// constructor
+Pool::Pool(int threads) :
+    threads_{threads}, workers_{}, done_{true}, callback_{nullptr}, batch_callback_{nullptr},
+    queue_{Constants::Worker::queue_size}, mutex_{}, cond_{}, sleeping_{0}
+{ }
+
+// destructor
+Pool::~Pool()
+{
+    stop();
+}
+
+// set the user callback
+void Pool::setUserCallback(WorkerCallback callback)
+{
+    callback_ = callback;
+}
+
+// set the user callback executing several tasks at once
+void Pool::setBatchCallback(BatchCallback callback)
+{
+    batch_callback_ = callback;
+}
+
+// start the threads
+void Pool::start()
+{
+    done_ = false;
+    for (int i = 0; i < threads_; ++i) {
+        workers_.push_back(std::thread(&Pool::serveTasks, this));
+    }
+}
+
+// stop the threads once the queue is empty
+void Pool::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        done_ = true;
+    }
+    cond_.notify_all();
+
+    for (auto& worker : workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    workers_.clear();
+}
+
+// add a task to the queue and wake up a worker if needed
+bool Pool::submit(Task* task)
+{
+    if (!queue_.push(task))
+        return false;
+
+    // the task is published before sleeping_ is read, a worker going to sleep
+    // either sees the task or is seen as sleeping (paired with serveTasks())
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    // the workers are busy: they will find the task by themselves
+    if (sleeping_.load() > 0) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cond_.notify_one();
+    }
+
+    return true;
+}
+
+// add the tasks already waiting to the batch, up to max_batch
+// while the tasks keep coming, wait a little for the next ones
+std::size_t Pool::collectTasks(std::vector<Task*>& batch)
+{
+    Task* task{nullptr};
+    auto deadline = std::chrono::steady_clock::now() + Constants::Worker::batch_window;
+
+    while (batch.size() < Constants::Worker::max_batch)
+    {
+        if (queue_.pop(task)) {
+            batch.push_back(task);
+            continue;
+        }
+
+        // a single task is not worth waiting for others
+        if ((batch.size() < 2) || (std::chrono::steady_clock::now() >= deadline))
+            break;
+
+        std::this_thread::yield();
+    }
+
+    return batch.size();
+}
+
+// threads mainloop
+void Pool::serveTasks()
+{
+    Task* task{nullptr};
+    std::vector<Task*> batch;
+
+    while (true)
+    {
+        // spin a little before going to sleep, tasks usually come in bursts
+        bool found{false};
+        for (int i = 0; i < Constants::Worker::spin_count; ++i) {
+            if (queue_.pop(task)) {
+                found = true;
+                break;
+            }
+            std::this_thread::yield();
+        }
+
+        if (!found) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            sleeping_++;
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            // check again once registered as sleeping to not miss a wake up
+            while (!(found = queue_.pop(task)) && !done_) {
+                cond_.wait_for(lock, Constants::Worker::sleep_timeout);
+            }
+
+            sleeping_--;
+        }
+
+        // the queue has been drained
+        if (!found)
+            return;
+
+        if (batch_callback_) {
+            batch.clear();
+            batch.push_back(task);
+            batch_callback_(batch.data(), collectTasks(batch));
+        } else if (callback_) {
+            callback_(task);
+        }
+    }
+}
+
+}   //< end namespace
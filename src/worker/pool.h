@@ -0,0 +1,90 @@
+/*
+ * @file    pool.h
+ * @brief   Header file for the Worker Pool class
+ */
+
+// ----- guards
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+// ----- includes
+#include "../network/response.h"
+#include "../vm/arena.h"
+#include "../vm/defines.h"
+#include "queue.h"
+
+#include <atomic>
+#include <cstddef>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+// ----- class
+namespace Worker
+{
+    // a request decoded by a reactor and executed by a worker
+    // the task lives in the arena of the request
+    struct Task
+    {
+        VM::Arena* arena;               //< memory of the request, released once the response is sent
+        VM::queue_t items;              //< the request items
+        VM::QueueItem* id;              //< request ID sent back with the response (optional)
+        int version;                    //< the response uses the frame format of the request
+        bool streamed;                  //< some parts of the response have been posted already
+        Network::Response* response;    //< the response posted back to the reactor
+    };
+
+    // called by the workers for each task
+    using WorkerCallback = std::function<void(Task*)>;
+
+    // called by the workers with all the tasks available at once
+    using BatchCallback = std::function<void(Task** tasks, std::size_t count)>;
+
+    // pool of threads executing the tasks submitted through a lock-free queue
+    // the threads only sleep when the queue stays empty
+    class Pool
+    {
+    public:     //< public methods
+        Pool(int threads);
+        ~Pool();
+
+        // no copy semantics
+        Pool(const Pool&) = delete;
+        Pool& operator=(const Pool&) = delete;
+
+        // no move semantics
+        Pool(Pool&&) = delete;
+        Pool& operator=(Pool&&) = delete;
+
+        void start();
+        void stop();                    //< execute the remaining tasks and wait for the threads
+
+        void setUserCallback(WorkerCallback callback);
+        void setBatchCallback(BatchCallback callback);      //< replaces the user callback
+
+        bool submit(Task* task);        //< false if the queue is full
+
+    private:    //< private methods
+        void serveTasks();              //< threads mainloop
+        std::size_t collectTasks(std::vector<Task*>& batch);    //< add the tasks available to the batch
+
+    private:    //< private members
+        int threads_;                       //< number of threads
+        std::vector<std::thread> workers_;  //< execution threads
+        std::atomic<bool> done_;            //< execution control variable
+
+        WorkerCallback callback_;           //< user callback
+        BatchCallback batch_callback_;      //< user callback for a batch of tasks
+
+        Queue<Task*> queue_;                //< tasks waiting for a worker
+        std::mutex mutex_;                  //< only used to sleep / wake up the workers
+        std::condition_variable cond_;
+        std::atomic<int> sleeping_;         //< number of workers waiting for a task
+    };
+
+}
+
+#endif // WORKER_POOL_H
@@ -0,0 +1,138 @@
+/*
+ * @file    queue.h
+ * @brief   Header file for the Worker lock-free Queue class
+ */
+
+// ----- guards
+#ifndef WORKER_QUEUE_H
+#define WORKER_QUEUE_H
+
+// ----- includes
+#include <atomic>
+#include <cstddef>
+
+
+// ----- class
+namespace Worker
+{
+    // bounded multi-producers / multi-consumers lock-free queue
+    // each cell carries a sequence number telling whether it can be written
+    // (sequence == position) or read (sequence == position + 1)
+    template <typename T>
+    class Queue
+    {
+    public:     //< public methods
+        // the capacity is rounded up to a power of 2
+        Queue(std::size_t capacity) :
+            cells_{nullptr}, mask_{0}, enqueue_pos_{0}, dequeue_pos_{0}
+        {
+            std::size_t size = 2;
+            while (size < capacity) {
+                size <<= 1;
+            }
+
+            cells_ = new Cell[size];
+            mask_ = size - 1;
+
+            for (std::size_t i = 0; i < size; ++i) {
+                cells_[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        ~Queue()
+        {
+            delete [] cells_;
+        }
+
+        // no copy semantics
+        Queue(const Queue&) = delete;
+        Queue& operator=(const Queue&) = delete;
+
+        // no move semantics
+        Queue(Queue&&) = delete;
+        Queue& operator=(Queue&&) = delete;
+
+        // add a value at the end of the queue, false if the queue is full
+        bool push(const T& value)
+        {
+            Cell* cell;
+            std::size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+
+            while (true)
+            {
+                cell = &cells_[pos & mask_];
+                std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+                std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+
+                // the cell is free: try to reserve it
+                if (diff == 0) {
+                    if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        break;
+                }
+                // the cell has not been read yet: the queue is full
+                else if (diff < 0) {
+                    return false;
+                }
+                // another producer took the cell
+                else {
+                    pos = enqueue_pos_.load(std::memory_order_relaxed);
+                }
+            }
+
+            cell->value = value;
+            cell->sequence.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+
+        // remove the value in front of the queue, false if the queue is empty
+        bool pop(T& value)
+        {
+            Cell* cell;
+            std::size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+
+            while (true)
+            {
+                cell = &cells_[pos & mask_];
+                std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+                std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos + 1);
+
+                // the cell has been written: try to reserve it
+                if (diff == 0) {
+                    if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        break;
+                }
+                // the cell has not been written yet: the queue is empty
+                else if (diff < 0) {
+                    return false;
+                }
+                // another consumer took the cell
+                else {
+                    pos = dequeue_pos_.load(std::memory_order_relaxed);
+                }
+            }
+
+            value = cell->value;
+            cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+            return true;
+        }
+
+    private:    //< private types
+        // keep the producers and the consumers on separate cache lines
+        static constexpr std::size_t cache_line_size{64};
+
+        struct Cell
+        {
+            std::atomic<std::size_t> sequence;
+            T value;
+        };
+
+    private:    //< private members
+        Cell* cells_;                                                   //< ring of cells
+        std::size_t mask_;                                              //< capacity - 1
+        alignas(cache_line_size) std::atomic<std::size_t> enqueue_pos_; //< next position to write
+        alignas(cache_line_size) std::atomic<std::size_t> dequeue_pos_; //< next position to read
+    };
+
+}
+
+#endif // WORKER_QUEUE_H